@@ -0,0 +1,741 @@
+// list benchmark suite
+// generates synthetic lists of growing size and times every list command on them, end to end through the
+// list executable (start the process, load the list, run the command, write the list back) and in process
+// through the listlib functions. the results come out as CSV or JSON with the median and percentiles of every
+// measurement, and can be checked against a baseline from an earlier run to catch slowdowns and complexity
+// regressions, such as an append that turns quadratic.
+//
+// build it next to the plugin, from list/v2:
+//   make listbench
+// and run it against a plugin binary:
+//   listbench --list ./list --sizes 1000,100000,1000000 --out today.csv
+//   listbench --list ./list --sizes 1000,100000,1000000 --baseline today.csv
+
+#include "../src/listlib.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#define NULL_DEVICE "NUL"
+#define DEFAULT_LIST "list.exe"
+#else
+#include <fcntl.h>
+#include <spawn.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#define NULL_DEVICE "/dev/null"
+#define DEFAULT_LIST "./list"
+extern char **environ;
+#endif
+
+// the list sizes measured when --sizes is not given
+#define BENCH_SIZES "1000,10000,100000,1000000"
+#define BENCH_REPS 5
+#define BENCH_ITEM_LEN 16
+// a median more than this many times its baseline is a slowdown
+#define BENCH_TOLERANCE 2.0
+// a measurement whose time grows faster with the list size than its baseline did, by this much of an exponent,
+// has changed complexity. an O(n) command that turns O(n^2) moves its exponent by a whole 1
+#define BENCH_GROWTH 0.5
+// measurements shorter than this, in microseconds, are mostly noise and are not compared
+#define BENCH_FLOOR 1000.0
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_ARGS 16
+
+// one measured command or function at one list size
+typedef struct result {
+    char kind[8];
+    char name[32];
+    long lines;
+    int item_len;
+    char content[8];
+    char engine[8];
+    int reps;
+    double min;
+    double median;
+    double p90;
+    double p99;
+    double max;
+} result;
+
+// the results of a whole run, or of a baseline read back from a file
+typedef struct results {
+    result *items;
+    int count;
+    int capacity;
+} results;
+
+// what the run was asked to do
+typedef struct settings {
+    char *list;
+    long sizes[BENCH_MAX_SIZES];
+    int size_count;
+    int item_len;
+    int numbers;
+    int reps;
+    int json;
+    char *out;
+    char *baseline;
+    double tolerance;
+    char *dir;
+    int e2e;
+    int func;
+} settings;
+
+// the values of a generated list the commands need to refer to
+typedef struct sample {
+    char middle[64];
+    char last[64];
+} sample;
+
+// the current time in microseconds, only differences between two calls mean anything
+static double now_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double) count.QuadPart * 1000000.0 / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#endif
+}
+
+// a small fast random number generator, so the lists are the same on every run and every platform
+static unsigned long long random_state = 88172645463325252ULL;
+static unsigned long long next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+// write a list file of synthetic items
+// numbers are signed integers of up to item_len digits, text items are item_len lowercase letters
+// the item in the middle and the last item are kept in sample for the commands that look for a value
+static int generate_list(char* filename, long lines, int item_len, int numbers, sample *picked) {
+    random_state = 88172645463325252ULL + lines;
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, 1024 * 1024);
+    char item[64];
+    int len = item_len < (int) sizeof(item) - 1 ? item_len : (int) sizeof(item) - 1;
+    for (long i = 0; i < lines; i++) {
+        if (numbers) {
+            // keep within 18 digits so every number fits a signed 64 bit integer
+            int digits = len < 18 ? len : 18;
+            unsigned long long limit = 1;
+            for (int d = 0; d < digits; d++) {
+                limit *= 10;
+            }
+            long long value = (long long) (next_random() % limit);
+            if (next_random() & 1) {
+                value = -value;
+            }
+            sprintf(item, "%lld", value);
+        }
+        else {
+            for (int c = 0; c < len; c++) {
+                item[c] = 'a' + next_random() % 26;
+            }
+            item[len] = '\0';
+        }
+        fputs(item, file);
+        fputc('\n', file);
+        if (i == lines / 2) {
+            strcpy(picked->middle, item);
+        }
+        if (i == lines - 1) {
+            strcpy(picked->last, item);
+        }
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+// copy a file, used to give every run of a command that changes the list a fresh copy of it
+static int copy_file(char* from, char* to) {
+    FILE *in = fopen(from, "rb");
+    if (in == NULL) {
+        return -1;
+    }
+    FILE *out = fopen(to, "wb");
+    if (out == NULL) {
+        fclose(in);
+        return -1;
+    }
+    char *buffer = malloc(1024 * 1024);
+    size_t got;
+    while ((got = fread(buffer, 1, 1024 * 1024, in)) > 0) {
+        fwrite(buffer, 1, got, out);
+    }
+    free(buffer);
+    fclose(in);
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+// delete a list file and everything the plugin keeps next to it
+static void remove_list(char* filename) {
+    char *suffixes[] = { "", ".idx", ".hix", ".tmp", ".lock" };
+    char name[4096];
+    for (int i = 0; i < 5; i++) {
+        snprintf(name, sizeof(name), "%s%s", filename, suffixes[i]);
+        remove(name);
+    }
+}
+
+// send stdout to the null device while an in process function prints, returns the real stdout to restore
+static int quiet_stdout(void) {
+    fflush(stdout);
+#ifdef _WIN32
+    int saved = _dup(_fileno(stdout));
+    int quiet = _open(NULL_DEVICE, _O_WRONLY);
+    _dup2(quiet, _fileno(stdout));
+    _close(quiet);
+#else
+    int saved = dup(STDOUT_FILENO);
+    int quiet = open(NULL_DEVICE, O_WRONLY);
+    dup2(quiet, STDOUT_FILENO);
+    close(quiet);
+#endif
+    return saved;
+}
+
+// bring back the stdout quiet_stdout put aside
+static void restore_stdout(int saved) {
+    fflush(stdout);
+#ifdef _WIN32
+    _dup2(saved, _fileno(stdout));
+    _close(saved);
+#else
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+#endif
+}
+
+// run the list executable with a set of arguments and time it from start to exit
+// its output goes to the null device, returns the time in microseconds or -1 if it could not be started
+static double run_list(char* binary, char** args, int *status) {
+#ifdef _WIN32
+    int saved = quiet_stdout();
+    double start = now_us();
+    intptr_t code = _spawnv(_P_WAIT, binary, (const char * const *) args);
+    double took = now_us() - start;
+    restore_stdout(saved);
+    *status = (int) code;
+    return code < 0 ? -1 : took;
+#else
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, NULL_DEVICE, O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, NULL_DEVICE, O_WRONLY, 0);
+    pid_t pid;
+    double start = now_us();
+    int failed = posix_spawn(&pid, binary, &actions, NULL, args, environ) != 0;
+    int code = 0;
+    if (!failed) {
+        waitpid(pid, &code, 0);
+    }
+    double took = now_us() - start;
+    posix_spawn_file_actions_destroy(&actions);
+    *status = WIFEXITED(code) ? WEXITSTATUS(code) : -1;
+    return failed ? -1 : took;
+#endif
+}
+
+static int compare_times(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+// the nearest rank percentile of sorted times
+static double percentile(double *times, int count, double rank) {
+    int at = (int) ceil(rank * count) - 1;
+    return times[at < 0 ? 0 : at];
+}
+
+// add a measurement to the results, the times are sorted in place
+static void add_result(results *all, char* kind, char* name, settings *run, long lines, double *times, int count) {
+    if (all->count == all->capacity) {
+        all->capacity = all->capacity == 0 ? 64 : all->capacity * 2;
+        all->items = realloc(all->items, sizeof(result) * all->capacity);
+    }
+    result *r = &all->items[all->count++];
+    memset(r, 0, sizeof(result));
+    qsort(times, count, sizeof(double), compare_times);
+    snprintf(r->kind, sizeof(r->kind), "%s", kind);
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->lines = lines;
+    r->item_len = run->item_len;
+    snprintf(r->content, sizeof(r->content), "%s", run->numbers ? "num" : "text");
+    char *engine = getenv("LIST_ENGINE");
+    snprintf(r->engine, sizeof(r->engine), "%s", engine != NULL && *engine != '\0' ? engine : "default");
+    r->reps = count;
+    r->min = times[0];
+    r->median = percentile(times, count, 0.5);
+    r->p90 = percentile(times, count, 0.9);
+    r->p99 = percentile(times, count, 0.99);
+    r->max = times[count - 1];
+    // show progress, the big sizes take a while
+    fprintf(stderr, "%-4s %-12s %10ld lines  median %12.1f us\n", kind, name, lines, r->median);
+}
+
+// a command run end to end, the arguments after the list file
+// changes is set if the command changes the list, every run then starts from a fresh copy
+typedef struct command {
+    char *name;
+    char *args[6];
+    int changes;
+    int numbers_only;
+} command;
+
+// time every command of the plugin end to end on a list of the given size
+static void bench_commands(settings *run, char* master, long lines, sample *picked, results *all) {
+    char work[4096];
+    snprintf(work, sizeof(work), "%s/bench_work", run->dir);
+    char middle[32];
+    char range_end[32];
+    sprintf(middle, "%ld", lines / 2);
+    sprintf(range_end, "%ld", lines / 2 + 99);
+    command commands[] = {
+        { "push", { "push", "benchitem" }, 1, 0 },
+        { "pop", { "pop" }, 1, 0 },
+        { "append", { "append", "benchitem" }, 1, 0 },
+        { "popback", { "popback" }, 1, 0 },
+        { "remove", { "remove", middle }, 1, 0 },
+        { "removewhere", { "removewhere", picked->middle }, 1, 0 },
+        { "get", { "get", middle }, 0, 0 },
+        { "print", { "print" }, 0, 0 },
+        { "print-range", { "print", middle, range_end }, 0, 0 },
+        { "insert", { "insert", middle, "benchitem" }, 1, 0 },
+        { "find", { "find", picked->middle }, 0, 0 },
+        { "getlength", { "getlength" }, 0, 0 },
+        { "sizeof", { "sizeof", middle }, 0, 0 },
+        { "reverse", { "reverse" }, 1, 0 },
+        { "pushset", { "pushset", "a", "b", "c", "0" }, 1, 0 },
+        { "removeset", { "removeset", picked->middle, picked->last }, 1, 0 },
+        { "sortstr", { "sortstr", "0" }, 1, 0 },
+        { "sortlex", { "sortlex", "byte", "0" }, 1, 0 },
+        { "sort", { "sort", "0" }, 1, 1 },
+        { "convert", { "convert", "front" }, 1, 0 },
+        { "waitpop", { "waitpop", "0" }, 1, 0 },
+    };
+    int count = sizeof(commands) / sizeof(command);
+    double *times = malloc(sizeof(double) * run->reps);
+    for (int c = 0; c < count; c++) {
+        command *cmd = &commands[c];
+        if (cmd->numbers_only && !run->numbers) {
+            continue;
+        }
+        char *args[BENCH_MAX_ARGS];
+        int argc = 0;
+        args[argc++] = run->list;
+        args[argc++] = work;
+        for (int i = 0; i < 6 && cmd->args[i] != NULL; i++) {
+            args[argc++] = cmd->args[i];
+        }
+        args[argc] = NULL;
+        // read-only commands share one copy, so the runs after the first find the line index in place
+        remove_list(work);
+        copy_file(master, work);
+        int done = 0;
+        for (int rep = 0; rep < run->reps; rep++) {
+            if (cmd->changes && rep > 0) {
+                remove_list(work);
+                copy_file(master, work);
+            }
+            int status;
+            double took = run_list(run->list, args, &status);
+            if (took < 0) {
+                fprintf(stderr, "Error: could not run %s\n", run->list);
+                exit(1);
+            }
+            if (status != 0 && rep == 0) {
+                fprintf(stderr, "Warning: %s exited with %i on %ld lines\n", cmd->name, status, lines);
+            }
+            times[done++] = took;
+        }
+        add_result(all, "e2e", cmd->name, run, lines, times, done);
+    }
+    remove_list(work);
+    free(times);
+}
+
+// the listlib functions measured in process
+#define FN_CREATE 0
+#define FN_PUSH 1
+#define FN_POP 2
+#define FN_APPEND 3
+#define FN_POP_END 4
+#define FN_INSERT 5
+#define FN_REM_INDEX 6
+#define FN_REM_VALUE 7
+#define FN_REM_VALUES 8
+#define FN_INDEX_OF 9
+#define FN_VALUE_LENGTH 10
+#define FN_PRINT_INDEX 11
+#define FN_PRINT_LIST 12
+#define FN_REVERSE 13
+#define FN_SORT 14
+#define FN_SORTSTRING 15
+#define FN_SORTLEX 16
+#define FN_SAVE_APPEND 17
+#define FN_EXPORT 18
+#define FN_COUNT 19
+
+static char *function_names[FN_COUNT] = {
+    "create_list", "push", "pop", "append", "pop_end", "insert_index", "rem_index", "rem_value", "rem_values",
+    "index_of", "value_length", "print_index", "print_list", "reverse", "sort", "sortstring", "sortlex",
+    "save_list", "export_list"
+};
+
+// time one call of a listlib function on a freshly loaded list
+static double time_function(int function, char* master, char* work, long lines, sample *picked) {
+    int middle = (int) (lines / 2);
+    // save_list writes the file the list came from, so it works on a copy
+    char *source = function == FN_SAVE_APPEND ? work : master;
+    if (function == FN_SAVE_APPEND) {
+        remove_list(work);
+        copy_file(master, work);
+    }
+    double start = now_us();
+    list_t *list = create_list(source);
+    if (function != FN_CREATE) {
+        start = now_us();
+    }
+    char *values[2] = { picked->middle, picked->last };
+    int found[2];
+    lex_order order = { { LEX_BYTE }, 1, 1, 0 };
+    int saved;
+    switch (function) {
+        case FN_PUSH: push(list, "benchitem"); break;
+        case FN_POP: pop(list); break;
+        case FN_APPEND: append(list, "benchitem"); break;
+        case FN_POP_END: pop_end(list); break;
+        case FN_INSERT: insert_index(list, middle, "benchitem"); break;
+        case FN_REM_INDEX: rem_index(list, middle); break;
+        case FN_REM_VALUE: rem_value(list, picked->middle); break;
+        case FN_REM_VALUES: rem_values(list, values, 2, found); break;
+        case FN_INDEX_OF: index_of(list, picked->middle); break;
+        case FN_VALUE_LENGTH: value_length(list, middle); break;
+        case FN_PRINT_INDEX:
+            saved = quiet_stdout();
+            print_index(list, middle);
+            restore_stdout(saved);
+            break;
+        case FN_PRINT_LIST:
+            saved = quiet_stdout();
+            print_list(list);
+            restore_stdout(saved);
+            break;
+        case FN_REVERSE: reverse(list); break;
+        case FN_SORT: sort(list, 1); break;
+        case FN_SORTSTRING: sortstring(list, 1); break;
+        case FN_SORTLEX: sortlex(list, &order); break;
+        case FN_SAVE_APPEND:
+            append(list, "benchitem");
+            start = now_us();
+            save_list(list, work);
+            break;
+        case FN_EXPORT: export_list(list, work); break;
+    }
+    double took = now_us() - start;
+    free_list(list);
+    return took;
+}
+
+// time every listlib function in process on a list of the given size
+static void bench_functions(settings *run, char* master, long lines, sample *picked, results *all) {
+    char work[4096];
+    snprintf(work, sizeof(work), "%s/bench_work", run->dir);
+    double *times = malloc(sizeof(double) * run->reps);
+    for (int f = 0; f < FN_COUNT; f++) {
+        if (f == FN_SORT && !run->numbers) {
+            continue;
+        }
+        for (int rep = 0; rep < run->reps; rep++) {
+            times[rep] = time_function(f, master, work, lines, picked);
+        }
+        add_result(all, "func", function_names[f], run, lines, times, run->reps);
+    }
+    remove_list(work);
+    free(times);
+}
+
+// write the results as CSV, one measurement per line after a header line
+static void write_csv(FILE *out, results *all) {
+    fprintf(out, "kind,name,lines,item_len,content,engine,reps,min_us,median_us,p90_us,p99_us,max_us\n");
+    for (int i = 0; i < all->count; i++) {
+        result *r = &all->items[i];
+        fprintf(out, "%s,%s,%ld,%i,%s,%s,%i,%.1f,%.1f,%.1f,%.1f,%.1f\n", r->kind, r->name, r->lines, r->item_len,
+            r->content, r->engine, r->reps, r->min, r->median, r->p90, r->p99, r->max);
+    }
+}
+
+// write the results as a JSON array with one object per measurement
+static void write_json(FILE *out, results *all) {
+    fprintf(out, "[\n");
+    for (int i = 0; i < all->count; i++) {
+        result *r = &all->items[i];
+        fprintf(out, "  {\"kind\": \"%s\", \"name\": \"%s\", \"lines\": %ld, \"item_len\": %i, \"content\": \"%s\", "
+            "\"engine\": \"%s\", \"reps\": %i, \"min_us\": %.1f, \"median_us\": %.1f, \"p90_us\": %.1f, "
+            "\"p99_us\": %.1f, \"max_us\": %.1f}%s\n", r->kind, r->name, r->lines, r->item_len, r->content,
+            r->engine, r->reps, r->min, r->median, r->p90, r->p99, r->max, i + 1 < all->count ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+// read the results of an earlier run written as CSV
+// returns 0 on success and -1 if the file could not be read
+static int read_baseline(char* filename, results *all) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[512];
+    // skip the header line
+    if (fgets(line, sizeof(line), file) == NULL) {
+        fclose(file);
+        return -1;
+    }
+    result r;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        memset(&r, 0, sizeof(result));
+        if (sscanf(line, "%7[^,],%31[^,],%ld,%i,%7[^,],%7[^,],%i,%lf,%lf,%lf,%lf,%lf", r.kind, r.name, &r.lines,
+            &r.item_len, r.content, r.engine, &r.reps, &r.min, &r.median, &r.p90, &r.p99, &r.max) != 12) {
+            continue;
+        }
+        if (all->count == all->capacity) {
+            all->capacity = all->capacity == 0 ? 64 : all->capacity * 2;
+            all->items = realloc(all->items, sizeof(result) * all->capacity);
+        }
+        all->items[all->count++] = r;
+    }
+    fclose(file);
+    return 0;
+}
+
+// check if two results measure the same thing, lines_too decides if the list size has to match as well
+static int same_measurement(result *a, result *b, int lines_too) {
+    return strcmp(a->kind, b->kind) == 0 && strcmp(a->name, b->name) == 0 && a->item_len == b->item_len &&
+        strcmp(a->content, b->content) == 0 && strcmp(a->engine, b->engine) == 0 && (!lines_too || a->lines == b->lines);
+}
+
+// find a measurement in a set of results, returns null if it is not there
+static result* find_result(results *all, result *like, long lines) {
+    for (int i = 0; i < all->count; i++) {
+        if (same_measurement(&all->items[i], like, 0) && all->items[i].lines == lines) {
+            return &all->items[i];
+        }
+    }
+    return NULL;
+}
+
+// how fast a time grows with the list size between two sizes, 1 for linear and 2 for quadratic
+static double growth(double small_time, long small_lines, double big_time, long big_lines) {
+    return log(big_time / small_time) / log((double) big_lines / (double) small_lines);
+}
+
+// compare the results with a baseline and report every slowdown and complexity change on stderr
+// returns the number of regressions found
+static int compare_baseline(results *now, results *base, double tolerance) {
+    int regressions = 0;
+    int compared = 0;
+    for (int i = 0; i < now->count; i++) {
+        result *r = &now->items[i];
+        result *old = find_result(base, r, r->lines);
+        if (old == NULL) {
+            continue;
+        }
+        compared++;
+        // a slowdown at the same size
+        if (r->median > BENCH_FLOOR && r->median > old->median * tolerance) {
+            fprintf(stderr, "REGRESSION %s %s at %ld lines: median %.1f us, baseline %.1f us (%.2fx)\n",
+                r->kind, r->name, r->lines, r->median, old->median, r->median / old->median);
+            regressions++;
+        }
+        // a change in how the time grows from the next smaller size that both runs measured
+        result *smaller = NULL;
+        for (int j = 0; j < now->count; j++) {
+            result *other = &now->items[j];
+            if (same_measurement(other, r, 0) && other->lines < r->lines && (smaller == NULL || other->lines > smaller->lines)) {
+                smaller = other;
+            }
+        }
+        if (smaller == NULL) {
+            continue;
+        }
+        result *old_smaller = find_result(base, smaller, smaller->lines);
+        if (old_smaller == NULL || r->median < BENCH_FLOOR || old->median < BENCH_FLOOR ||
+            smaller->median <= 0 || old_smaller->median <= 0) {
+            continue;
+        }
+        double now_growth = growth(smaller->median, smaller->lines, r->median, r->lines);
+        double old_growth = growth(old_smaller->median, old_smaller->lines, old->median, old->lines);
+        if (now_growth > old_growth + BENCH_GROWTH) {
+            fprintf(stderr, "COMPLEXITY %s %s from %ld to %ld lines: grows as n^%.2f, baseline n^%.2f\n",
+                r->kind, r->name, smaller->lines, r->lines, now_growth, old_growth);
+            regressions++;
+        }
+    }
+    fprintf(stderr, "%i measurements compared with the baseline, %i regressions\n", compared, regressions);
+    return regressions;
+}
+
+// read a comma separated list of sizes such as 1000,1M,10M
+static int read_sizes(char* text, settings *run) {
+    run->size_count = 0;
+    char *copy = strdup(text);
+    for (char *part = strtok(copy, ","); part != NULL; part = strtok(NULL, ",")) {
+        char *end;
+        double value = strtod(part, &end);
+        if (*end == 'k' || *end == 'K') {
+            value *= 1000;
+            end++;
+        }
+        else if (*end == 'm' || *end == 'M') {
+            value *= 1000000;
+            end++;
+        }
+        if (end == part || *end != '\0' || value < 1 || run->size_count == BENCH_MAX_SIZES) {
+            free(copy);
+            return -1;
+        }
+        run->sizes[run->size_count++] = (long) value;
+    }
+    free(copy);
+    return run->size_count > 0 ? 0 : -1;
+}
+
+static void usage(char* program) {
+    printf("Usage: %s [--list <list executable>] [--sizes 1000,100k,10M] [--item-len <bytes>] [--content text|num]\n", program);
+    printf("\t[--reps <n>] [--only e2e|func] [--format csv|json] [--out <file>] [--baseline <csv file>] [--tolerance <ratio>] [--dir <directory>]\n");
+}
+
+int main(int argc, char** argv) {
+    settings run;
+    memset(&run, 0, sizeof(run));
+    run.list = DEFAULT_LIST;
+    run.item_len = BENCH_ITEM_LEN;
+    run.reps = BENCH_REPS;
+    run.tolerance = BENCH_TOLERANCE;
+    run.dir = ".";
+    run.e2e = 1;
+    run.func = 1;
+    read_sizes(BENCH_SIZES, &run);
+    for (int i = 1; i < argc; i++) {
+        char *option = argv[i];
+        char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(option, "-?") == 0 || strcmp(option, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        if (value == NULL) {
+            printf("Missing value for %s\n", option);
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+        if (strcmp(option, "--list") == 0) {
+            run.list = value;
+        }
+        else if (strcmp(option, "--sizes") == 0) {
+            if (read_sizes(value, &run) != 0) {
+                printf("Invalid sizes \"%s\", use a comma separated list such as 1000,100k,10M\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(option, "--item-len") == 0) {
+            run.item_len = atoi(value);
+        }
+        else if (strcmp(option, "--content") == 0) {
+            run.numbers = strcmp(value, "num") == 0;
+        }
+        else if (strcmp(option, "--reps") == 0) {
+            run.reps = atoi(value);
+        }
+        else if (strcmp(option, "--only") == 0) {
+            run.e2e = strcmp(value, "e2e") == 0;
+            run.func = strcmp(value, "func") == 0;
+        }
+        else if (strcmp(option, "--format") == 0) {
+            run.json = strcmp(value, "json") == 0;
+        }
+        else if (strcmp(option, "--out") == 0) {
+            run.out = value;
+        }
+        else if (strcmp(option, "--baseline") == 0) {
+            run.baseline = value;
+        }
+        else if (strcmp(option, "--tolerance") == 0) {
+            run.tolerance = atof(value);
+        }
+        else if (strcmp(option, "--dir") == 0) {
+            run.dir = value;
+        }
+        else {
+            printf("Unknown option %s\n", option);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (run.item_len < 1 || run.reps < 1 || run.tolerance <= 1.0) {
+        printf("Item length and repetitions must be at least 1 and the tolerance more than 1.\n");
+        return 1;
+    }
+    results base;
+    memset(&base, 0, sizeof(base));
+    if (run.baseline != NULL && read_baseline(run.baseline, &base) != 0) {
+        printf("Error: could not read baseline %s\n", run.baseline);
+        return 1;
+    }
+
+    results all;
+    memset(&all, 0, sizeof(all));
+    char master[4096];
+    snprintf(master, sizeof(master), "%s/bench_list", run.dir);
+    for (int s = 0; s < run.size_count; s++) {
+        sample picked;
+        if (generate_list(master, run.sizes[s], run.item_len, run.numbers, &picked) != 0) {
+            printf("Error: could not write %s\n", master);
+            return 4;
+        }
+        if (run.e2e) {
+            bench_commands(&run, master, run.sizes[s], &picked, &all);
+        }
+        if (run.func) {
+            bench_functions(&run, master, run.sizes[s], &picked, &all);
+        }
+    }
+    remove_list(master);
+
+    FILE *out = run.out != NULL ? fopen(run.out, "w") : stdout;
+    if (out == NULL) {
+        printf("Error: could not write %s\n", run.out);
+        return 4;
+    }
+    if (run.json) {
+        write_json(out, &all);
+    }
+    else {
+        write_csv(out, &all);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    // a regression fails the run, so a script can stop on it
+    if (run.baseline != NULL && compare_baseline(&all, &base, run.tolerance) > 0) {
+        return 2;
+    }
+    return 0;
+}
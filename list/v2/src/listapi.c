@@ -0,0 +1,296 @@
+// list api library
+// wraps the list library for programs that embed it: every call works on a handle, reports a status code
+// instead of printing or exiting, and allocates through the allocator the handle was opened with
+
+#include "listapi.h"
+#include "listlib.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+struct list_handle {
+    list_t *list;
+    char *filename;
+    list_lock lock;
+    list_allocator allocator;
+    unsigned long long failures;
+};
+
+// make the handle's allocator the one the library allocates through for the length of a call
+// returns the allocator it replaces, leave puts that one back
+static list_allocator* enter(list_handle *handle) {
+    list_allocator *previous = library_allocator;
+    library_allocator = handle->allocator.allocate != NULL ? &handle->allocator : NULL;
+    handle->failures = library_stats.failed_allocations;
+    return previous;
+}
+
+// the status of a call that failed, LIST_NO_MEMORY if an allocation failed since the call was entered
+// the library reports running out of memory with the same codes as its other failures
+static int failure(list_handle *handle, int status) {
+    return library_stats.failed_allocations != handle->failures ? LIST_NO_MEMORY : status;
+}
+
+// end a call, returns its status
+static int leave(list_allocator *previous, int status) {
+    library_allocator = previous;
+    return status;
+}
+
+int list_open(const char* filename, int create, const list_allocator *allocator, list_handle **handle) {
+    if (filename == NULL || handle == NULL) {
+        return LIST_ARG_FAILURE;
+    }
+    // the handle itself comes from the caller's allocator too
+    list_allocator *previous = library_allocator;
+    list_allocator given;
+    memset(&given, 0, sizeof(given));
+    if (allocator != NULL && allocator->allocate != NULL) {
+        given = *allocator;
+        library_allocator = &given;
+    }
+    list_handle *opened = counted_malloc(sizeof(list_handle));
+    if (opened == NULL) {
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    opened->allocator = given;
+    library_allocator = given.allocate != NULL ? &opened->allocator : NULL;
+    opened->list = NULL;
+    opened->failures = library_stats.failed_allocations;
+    opened->filename = counted_malloc(strlen(filename) + 1);
+    if (opened->filename == NULL) {
+        counted_free(opened);
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    strcpy(opened->filename, filename);
+    // hold the writer lock from before the list is read until the handle is closed
+    if (lock_list(opened->filename, &opened->lock) != 0) {
+        int status = failure(opened, LIST_FILE_ERROR);
+        counted_free(opened->filename);
+        counted_free(opened);
+        return leave(previous, status);
+    }
+    opened->list = create_list(opened->filename);
+    if (opened->list == NULL) {
+        // a file that is there but did not load is damaged, it is left alone rather than started over empty
+        struct stat st;
+        int exists = stat(opened->filename, &st) == 0;
+        opened->list = exists || !create ? NULL : new_list();
+        if (opened->list == NULL) {
+            int status = failure(opened, exists ? LIST_FILE_ERROR : create ? LIST_NO_MEMORY : LIST_ARG_FAILURE);
+            unlock_list(&opened->lock);
+            counted_free(opened->filename);
+            counted_free(opened);
+            return leave(previous, status);
+        }
+        // a new list is written out whole by list_save, even while it is empty
+        opened->list->dirty = 1;
+    }
+    *handle = opened;
+    return leave(previous, LIST_OK);
+}
+
+int list_save(list_handle *handle) {
+    list_allocator *previous = enter(handle);
+    return leave(previous, save_list(handle->list, handle->filename) == 0 ? LIST_OK : failure(handle, LIST_FILE_ERROR));
+}
+
+void list_close(list_handle *handle) {
+    if (handle == NULL) {
+        return;
+    }
+    list_allocator *previous = enter(handle);
+    free_list(handle->list);
+    unlock_list(&handle->lock);
+    counted_free(handle->filename);
+    // the handle holds the allocator, so it is put back before the handle is freed with it
+    list_allocator allocator = handle->allocator;
+    library_allocator = allocator.allocate != NULL ? &allocator : NULL;
+    counted_free(handle);
+    leave(previous, LIST_OK);
+}
+
+int list_count(list_handle *handle) {
+    return length(handle->list);
+}
+
+int list_get(list_handle *handle, int index, const char **value, size_t *len) {
+    if (length(handle->list) == 0) {
+        return LIST_EMPTY_LIST;
+    }
+    char *found = get_value(handle->list, index);
+    if (found == NULL) {
+        return LIST_INDEX_OUT_OF_BOUNDS;
+    }
+    *value = found;
+    if (len != NULL) {
+        *len = value_length(handle->list, index);
+    }
+    return LIST_OK;
+}
+
+int list_find(list_handle *handle, const char* value, int *index) {
+    list_allocator *previous = enter(handle);
+    int found = index_of(handle->list, (char *) value);
+    if (found < 0) {
+        return leave(previous, LIST_EMPTY_LIST);
+    }
+    *index = found;
+    return leave(previous, LIST_OK);
+}
+
+int list_push(list_handle *handle, const char* value) {
+    list_allocator *previous = enter(handle);
+    return leave(previous, push(handle->list, (char *) value) == 0 ? LIST_OK : LIST_NO_MEMORY);
+}
+
+int list_append(list_handle *handle, const char* value) {
+    list_allocator *previous = enter(handle);
+    return leave(previous, append(handle->list, (char *) value) == 0 ? LIST_OK : LIST_NO_MEMORY);
+}
+
+int list_insert(list_handle *handle, int index, const char* value) {
+    list_allocator *previous = enter(handle);
+    int result = insert_index(handle->list, index, (char *) value);
+    if (result == -1) {
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    return leave(previous, result == 0 ? LIST_OK : LIST_INDEX_OUT_OF_BOUNDS);
+}
+
+int list_pop(list_handle *handle, const char **value) {
+    list_allocator *previous = enter(handle);
+    char *popped = pop(handle->list);
+    if (popped == NULL) {
+        return leave(previous, LIST_EMPTY_LIST);
+    }
+    *value = popped;
+    return leave(previous, LIST_OK);
+}
+
+int list_pop_back(list_handle *handle, const char **value) {
+    list_allocator *previous = enter(handle);
+    char *popped = pop_end(handle->list);
+    if (popped == NULL) {
+        return leave(previous, LIST_EMPTY_LIST);
+    }
+    *value = popped;
+    return leave(previous, LIST_OK);
+}
+
+int list_remove(list_handle *handle, int index, const char **value) {
+    if (length(handle->list) == 0) {
+        return LIST_EMPTY_LIST;
+    }
+    list_allocator *previous = enter(handle);
+    char *removed = rem_index(handle->list, index);
+    if (removed == NULL) {
+        return leave(previous, LIST_INDEX_OUT_OF_BOUNDS);
+    }
+    if (value != NULL) {
+        *value = removed;
+    }
+    return leave(previous, LIST_OK);
+}
+
+int list_remove_value(list_handle *handle, const char* value) {
+    list_allocator *previous = enter(handle);
+    char *removed = rem_value(handle->list, (char *) value);
+    return leave(previous, removed != NULL ? LIST_OK : LIST_EMPTY_LIST);
+}
+
+int list_reverse(list_handle *handle) {
+    list_allocator *previous = enter(handle);
+    return leave(previous, reverse(handle->list) == 0 ? LIST_OK : LIST_EMPTY_LIST);
+}
+
+int list_sort(list_handle *handle, int ascending) {
+    if (length(handle->list) == 0) {
+        return LIST_EMPTY_LIST;
+    }
+    list_allocator *previous = enter(handle);
+    int result = sort(handle->list, ascending != 0);
+    if (result == -2) {
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    return leave(previous, result == 0 ? LIST_OK : LIST_INVALID);
+}
+
+int list_sort_length(list_handle *handle, int ascending) {
+    list_allocator *previous = enter(handle);
+    int result = sortstring(handle->list, ascending != 0);
+    if (result == -2) {
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    return leave(previous, result == 0 ? LIST_OK : LIST_EMPTY_LIST);
+}
+
+int list_sort_lex(list_handle *handle, const char* modes, int ascending, int stable) {
+    lex_order order;
+    order.keys = 0;
+    order.ascending = ascending != 0;
+    order.stable = stable != 0;
+    // read the modes one at a time, they are separated by commas
+    const char *mode = modes != NULL ? modes : "";
+    for (;;) {
+        const char *comma = strchr(mode, ',');
+        size_t len = comma != NULL ? (size_t) (comma - mode) : strlen(mode);
+        char name[32];
+        if (len >= sizeof(name) || order.keys == LEX_KEYS) {
+            return LIST_ARG_FAILURE;
+        }
+        memcpy(name, mode, len);
+        name[len] = '\0';
+        int parsed = lex_mode(name);
+        if (parsed < 0) {
+            return LIST_ARG_FAILURE;
+        }
+        order.modes[order.keys++] = parsed;
+        if (comma == NULL) {
+            break;
+        }
+        mode = comma + 1;
+    }
+    list_allocator *previous = enter(handle);
+    int result = sortlex(handle->list, &order);
+    if (result == -2) {
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    return leave(previous, result == 0 ? LIST_OK : LIST_EMPTY_LIST);
+}
+
+int list_print(list_handle *handle, int from, int to, list_output output, void *context) {
+    list_allocator *previous = enter(handle);
+    int result = write_range(handle->list, from, to, output, context);
+    if (result == -1) {
+        return leave(previous, LIST_EMPTY_LIST);
+    }
+    if (result == -2 || result == -3) {
+        return leave(previous, LIST_INDEX_OUT_OF_BOUNDS);
+    }
+    if (result == -5) {
+        return leave(previous, LIST_NO_MEMORY);
+    }
+    return leave(previous, result == 0 ? LIST_OK : LIST_FILE_ERROR);
+}
+
+const char* list_status_text(int status) {
+    switch (status) {
+        case LIST_OK:
+            return "OK";
+        case LIST_ARG_FAILURE:
+            return "ARG_FAILURE";
+        case LIST_EMPTY_LIST:
+            return "EMPTY_LIST";
+        case LIST_INDEX_OUT_OF_BOUNDS:
+            return "INDEX_OUT_OF_BOUNDS";
+        case LIST_FILE_ERROR:
+            return "FILE_ERROR";
+        case LIST_INVALID:
+            return "INVALID";
+        case LIST_NO_MEMORY:
+            return "NO_MEMORY";
+        default:
+            return "UNKNOWN";
+    }
+}
@@ -0,0 +1,111 @@
+// header file for listapi.c
+// the list library for programs that work on lists in process instead of running list.exe for every command
+
+#ifndef LISTAPI_H
+#define LISTAPI_H
+
+#include "liststat.h"
+#include <stddef.h>
+
+// functions of a shared library build are exported from the dll on windows and imported by programs using it,
+// define LIST_SHARED_BUILD when building the dll and LIST_SHARED when using it
+#if defined(_WIN32) && defined(LIST_SHARED_BUILD)
+#define LIST_EXPORT __declspec(dllexport)
+#elif defined(_WIN32) && defined(LIST_SHARED)
+#define LIST_EXPORT __declspec(dllimport)
+#else
+#define LIST_EXPORT
+#endif
+
+// status codes, the same numbers list.exe exits with
+#define LIST_OK 0
+#define LIST_ARG_FAILURE 1
+#define LIST_EMPTY_LIST 2
+#define LIST_INDEX_OUT_OF_BOUNDS 3
+#define LIST_FILE_ERROR 4
+#define LIST_INVALID 5
+#define LIST_NO_MEMORY 6
+
+// an open list file
+// the handle holds the list in memory and the writer lock of its file from list_open to list_close,
+// like list.exe does for one command. handles share nothing, so different threads can each use their own.
+// one handle must not be used by two threads at once
+typedef struct list_handle list_handle;
+
+// where list_print sends the items, it is given runs of bytes to write and returns 0 on success
+typedef int (*list_output)(void *context, const char *bytes, size_t len);
+
+// open a list file, waiting for any other writer of the file to finish
+// if the file does not exist it is an error unless create is set, then the list starts empty and list_save creates it.
+// allocator may be null to use malloc, realloc and free, otherwise everything the handle holds comes from it
+// returns LIST_OK and stores the handle, LIST_ARG_FAILURE if the file does not exist,
+// LIST_FILE_ERROR if its lock could not be taken or the file could not be read, a damaged binary or block list
+// is never replaced, or LIST_NO_MEMORY
+LIST_EXPORT int list_open (const char* filename, int create, const list_allocator *allocator, list_handle **handle);
+
+// write the changes made through the handle back to the list file, only the change is written like list.exe does
+// returns LIST_OK, LIST_FILE_ERROR or LIST_NO_MEMORY
+LIST_EXPORT int list_save (list_handle *handle);
+
+// release the lock and free the handle and its list, changes that were not saved are lost
+LIST_EXPORT void list_close (list_handle *handle);
+
+// the number of items in the list
+LIST_EXPORT int list_count (list_handle *handle);
+
+// the values handed out by the functions below belong to the handle and stay valid until list_close.
+// values given to them are copied
+
+// get the value at an index and its length
+// returns LIST_OK, LIST_EMPTY_LIST or LIST_INDEX_OUT_OF_BOUNDS
+LIST_EXPORT int list_get (list_handle *handle, int index, const char **value, size_t *len);
+
+// find the index of the first item holding a value
+// returns LIST_OK or LIST_EMPTY_LIST if no item holds it
+LIST_EXPORT int list_find (list_handle *handle, const char* value, int *index);
+
+// add an item at the front or at the end of the list
+// returns LIST_OK or LIST_NO_MEMORY, the list is then left as it was
+LIST_EXPORT int list_push (list_handle *handle, const char* value);
+LIST_EXPORT int list_append (list_handle *handle, const char* value);
+
+// insert an item at an index, the item at the index and those after it move one place down
+// returns LIST_OK, LIST_INDEX_OUT_OF_BOUNDS or LIST_NO_MEMORY
+LIST_EXPORT int list_insert (list_handle *handle, int index, const char* value);
+
+// remove the first or the last item and hand out its value
+// returns LIST_OK or LIST_EMPTY_LIST
+LIST_EXPORT int list_pop (list_handle *handle, const char **value);
+LIST_EXPORT int list_pop_back (list_handle *handle, const char **value);
+
+// remove the item at an index and hand out its value
+// returns LIST_OK, LIST_EMPTY_LIST or LIST_INDEX_OUT_OF_BOUNDS
+LIST_EXPORT int list_remove (list_handle *handle, int index, const char **value);
+
+// remove the first item holding a value
+// returns LIST_OK or LIST_EMPTY_LIST if no item holds it
+LIST_EXPORT int list_remove_value (list_handle *handle, const char* value);
+
+// reverse the list, returns LIST_OK or LIST_EMPTY_LIST
+LIST_EXPORT int list_reverse (list_handle *handle);
+
+// sort the list by number like the sort command
+// returns LIST_OK, LIST_EMPTY_LIST, LIST_INVALID if an item is not an integer or LIST_NO_MEMORY
+LIST_EXPORT int list_sort (list_handle *handle, int ascending);
+
+// sort the list by length like the sortstr command, returns LIST_OK, LIST_EMPTY_LIST or LIST_NO_MEMORY
+LIST_EXPORT int list_sort_length (list_handle *handle, int ascending);
+
+// sort the list like the sortlex command, modes is its list of modes such as "nocase,length"
+// returns LIST_OK, LIST_EMPTY_LIST, LIST_ARG_FAILURE if a mode is not valid or LIST_NO_MEMORY
+LIST_EXPORT int list_sort_lex (list_handle *handle, const char* modes, int ascending, int stable);
+
+// hand the items from one index to another, both included, to output, each followed by a newline
+// a to past the last item stops at the last item
+// returns LIST_OK, LIST_EMPTY_LIST, LIST_INDEX_OUT_OF_BOUNDS, LIST_FILE_ERROR if output failed or LIST_NO_MEMORY
+LIST_EXPORT int list_print (list_handle *handle, int from, int to, list_output output, void *context);
+
+// a short description of a status code
+LIST_EXPORT const char* list_status_text (int status);
+
+#endif
@@ -0,0 +1,497 @@
+// block list library
+// reads and writes block lists, lists kept in compressed blocks with an index of the blocks at the end of the file.
+// a command that needs one item only ever decompresses the block holding it
+
+#include "listblk.h"
+#include "listhash.h"
+#include "listlz.h"
+#include "listscan.h"
+#include "liststat.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the first text buffer of a writer, it doubles when an item does not fit
+#define BLOCK_TEXT (64 * 1024)
+
+int block_magic(char* bytes, long size) {
+    return size >= (long) sizeof(blk_header) && memcmp(bytes, BLOCK_MAGIC, strlen(BLOCK_MAGIC)) == 0;
+}
+
+// check a block index against its header and the size of the file
+// every block has to lie between the header and the index and the lines of the blocks have to add up to the count
+// returns 0 if it holds together and -1 if not
+static int check_index(blk_header *header, blk_entry *entries, uint64_t size) {
+    uint64_t lines = 0;
+    for (uint64_t i = 0; i < header->blocks; i++) {
+        blk_entry *entry = &entries[i];
+        if (entry->offset < sizeof(blk_header) || entry->offset > header->index ||
+            entry->packed > header->index - entry->offset || entry->lines == 0) {
+            return -1;
+        }
+        lines += entry->lines;
+    }
+    if (lines != header->count || header->count >= INT_MAX || header->index > size) {
+        return -1;
+    }
+    return 0;
+}
+
+// read the header and the index of a block list from an open file, size is the size of the file
+// returns 0 on success, 1 if the file is not a block list and -1 if it is damaged or there is no memory for the index
+static int read_index(FILE *file, uint64_t size, blk_header *header, blk_entry **entries) {
+    *entries = NULL;
+    fseek(file, 0, SEEK_SET);
+    if (size < sizeof(blk_header) || fread(header, sizeof(blk_header), 1, file) != 1 ||
+        memcmp(header->magic, BLOCK_MAGIC, strlen(BLOCK_MAGIC)) != 0) {
+        return 1;
+    }
+    library_stats.bytes_read += sizeof(blk_header);
+    // the index has to fit between where it starts and the end of the file
+    if (header->index < sizeof(blk_header) || header->index > size ||
+        header->blocks > (size - header->index) / sizeof(blk_entry)) {
+        return -1;
+    }
+    *entries = counted_malloc(sizeof(blk_entry) * (header->blocks + 1));
+    if (*entries == NULL) {
+        return -1;
+    }
+    fseek(file, (long) header->index, SEEK_SET);
+    if (fread(*entries, sizeof(blk_entry), header->blocks, file) != header->blocks ||
+        check_index(header, *entries, size) != 0) {
+        counted_free(*entries);
+        *entries = NULL;
+        return -1;
+    }
+    library_stats.bytes_read += sizeof(blk_entry) * header->blocks;
+    return 0;
+}
+
+// the size of an open file
+static uint64_t file_size(FILE *file) {
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    return size > 0 ? (uint64_t) size : 0;
+}
+
+// decompress a block into text, which has room for its size, and check it against its checksum
+// the block has to hold as many lines as the index says, the last one ending in a newline, so the lines
+// of a block that passed can be walked without looking for the end of the text
+// returns 0 on success and -1 if the block is damaged
+static int unpack_block(blk_entry *entry, char *packed, char *text) {
+    if (lz_decompress(packed, entry->packed, text, entry->size) != 0 || entry->size == 0 ||
+        text[entry->size - 1] != '\n' || hash_value(text, entry->size) != entry->checksum ||
+        count_newlines(text, entry->size) != entry->lines) {
+        return -1;
+    }
+    return 0;
+}
+
+int block_open(char* filename, block_list *blocks) {
+    memset(blocks, 0, sizeof(block_list));
+    blocks->current = -1;
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return 1;
+    }
+    library_stats.opens++;
+    int result = read_index(file, file_size(file), &blocks->header, &blocks->entries);
+    if (result != 0) {
+        fclose(file);
+        return result;
+    }
+    blocks->file = file;
+    // where each block starts in the list, and buffers big enough for the biggest block
+    blocks->first = counted_malloc(sizeof(uint64_t) * (blocks->header.blocks + 1));
+    if (blocks->first == NULL) {
+        block_close(blocks);
+        return -1;
+    }
+    uint64_t first = 0;
+    size_t packed = 0;
+    size_t size = 0;
+    for (uint64_t i = 0; i < blocks->header.blocks; i++) {
+        blk_entry *entry = &blocks->entries[i];
+        blocks->first[i] = first;
+        first += entry->lines;
+        packed = entry->packed > packed ? entry->packed : packed;
+        size = entry->size > size ? entry->size : size;
+    }
+    blocks->first[blocks->header.blocks] = first;
+    blocks->packed = counted_malloc(packed + 1);
+    blocks->text = counted_malloc(size + 1);
+    if (blocks->packed == NULL || blocks->text == NULL) {
+        block_close(blocks);
+        return -1;
+    }
+    return 0;
+}
+
+void block_close(block_list *blocks) {
+    if (blocks->file != NULL) {
+        fclose(blocks->file);
+    }
+    counted_free(blocks->entries);
+    counted_free(blocks->first);
+    counted_free(blocks->packed);
+    counted_free(blocks->text);
+    memset(blocks, 0, sizeof(block_list));
+}
+
+long block_count(char* filename) {
+    block_list blocks;
+    if (block_open(filename, &blocks) != 0) {
+        return -1;
+    }
+    long count = (long) blocks.header.count;
+    block_close(&blocks);
+    return count;
+}
+
+uint64_t block_bytes(block_list *blocks) {
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < blocks->header.blocks; i++) {
+        bytes += blocks->entries[i].size;
+    }
+    return bytes;
+}
+
+// read and decompress a block into the list's text, unless it is the block already there
+// returns 0 on success and -1 if the block is damaged
+static int load_block(block_list *blocks, uint64_t block) {
+    if (blocks->current == (int64_t) block) {
+        return 0;
+    }
+    blocks->current = -1;
+    blk_entry *entry = &blocks->entries[block];
+    fseek(blocks->file, (long) entry->offset, SEEK_SET);
+    if (fread(blocks->packed, 1, entry->packed, blocks->file) != entry->packed) {
+        return -1;
+    }
+    library_stats.bytes_read += entry->packed;
+    if (unpack_block(entry, blocks->packed, blocks->text) != 0) {
+        return -1;
+    }
+    blocks->current = (int64_t) block;
+    return 0;
+}
+
+// find the block holding the item at an index, the index has to be in the list
+static uint64_t find_block(block_list *blocks, uint64_t index) {
+    // the last block whose first item is not past the index
+    uint64_t low = 0;
+    uint64_t high = blocks->header.blocks - 1;
+    while (low < high) {
+        uint64_t middle = low + (high - low + 1) / 2;
+        if (blocks->first[middle] <= index) {
+            low = middle;
+        }
+        else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+// find the line of the loaded block that holds the item at an index of the list
+// returns the start of the line, its end is the next newline
+static char* find_line(block_list *blocks, uint64_t block, uint64_t index) {
+    char *pos = blocks->text;
+    char *end = blocks->text + blocks->entries[block].size;
+    for (uint64_t skip = index - blocks->first[block]; skip > 0; skip--) {
+        pos = find_newline(pos, end - pos) + 1;
+    }
+    return pos;
+}
+
+int block_item(block_list *blocks, int index, char **item, size_t *len) {
+    if (blocks->header.count == 0) {
+        return -1;
+    }
+    if (index < 0) {
+        return -2;
+    }
+    if ((uint64_t) index >= blocks->header.count) {
+        return -3;
+    }
+    uint64_t block = find_block(blocks, index);
+    if (load_block(blocks, block) != 0) {
+        return -5;
+    }
+    char *start = find_line(blocks, block, index);
+    char *end = blocks->text + blocks->entries[block].size;
+    *item = start;
+    *len = find_newline(start, end - start) - start;
+    return 0;
+}
+
+int block_index_of(block_list *blocks, char* value) {
+    size_t len = strlen(value);
+    int index = 0;
+    for (uint64_t block = 0; block < blocks->header.blocks; block++) {
+        if (load_block(blocks, block) != 0) {
+            return -5;
+        }
+        // compare the value with every line of the block
+        char *pos = blocks->text;
+        char *end = blocks->text + blocks->entries[block].size;
+        while (pos < end) {
+            char *newline = find_newline(pos, end - pos);
+            if ((size_t) (newline - pos) == len && memcmp(pos, value, len) == 0) {
+                return index;
+            }
+            pos = newline + 1;
+            index++;
+        }
+    }
+    return -1;
+}
+
+int block_print(block_list *blocks, int from, int to) {
+    if (blocks->header.count == 0) {
+        return -1;
+    }
+    if (from < 0) {
+        return -2;
+    }
+    if ((uint64_t) from >= blocks->header.count || from > to) {
+        return -3;
+    }
+    uint64_t last = (uint64_t) to < blocks->header.count ? (uint64_t) to : blocks->header.count - 1;
+    // every block of the range goes out in one write, the first and the last only in part
+    for (uint64_t block = find_block(blocks, from); block < blocks->header.blocks && blocks->first[block] <= last; block++) {
+        if (load_block(blocks, block) != 0) {
+            return -5;
+        }
+        blk_entry *entry = &blocks->entries[block];
+        char *start = blocks->first[block] < (uint64_t) from ? find_line(blocks, block, from) : blocks->text;
+        char *end = blocks->text + entry->size;
+        if (last + 1 < blocks->first[block] + entry->lines) {
+            end = find_line(blocks, block, last + 1);
+        }
+        fwrite(start, 1, end - start, stdout);
+    }
+    return 0;
+}
+
+char* block_unpack(char* bytes, long size, long *text_size) {
+    blk_header header;
+    memcpy(&header, bytes, sizeof(blk_header));
+    if (header.index < sizeof(blk_header) || header.index > (uint64_t) size ||
+        header.blocks > ((uint64_t) size - header.index) / sizeof(blk_entry)) {
+        return NULL;
+    }
+    // the index may not be aligned in the buffer, it is copied out
+    blk_entry *entries = counted_malloc(sizeof(blk_entry) * (header.blocks + 1));
+    if (entries == NULL) {
+        return NULL;
+    }
+    memcpy(entries, bytes + header.index, sizeof(blk_entry) * header.blocks);
+    if (check_index(&header, entries, size) != 0) {
+        counted_free(entries);
+        return NULL;
+    }
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < header.blocks; i++) {
+        total += entries[i].size;
+    }
+    char *text = counted_malloc(total + 1);
+    if (text == NULL) {
+        counted_free(entries);
+        return NULL;
+    }
+    uint64_t used = 0;
+    for (uint64_t i = 0; i < header.blocks; i++) {
+        if (unpack_block(&entries[i], bytes + entries[i].offset, text + used) != 0) {
+            counted_free(entries);
+            counted_free(text);
+            return NULL;
+        }
+        used += entries[i].size;
+    }
+    counted_free(entries);
+    *text_size = (long) used;
+    return text;
+}
+
+void block_start(block_writer *writer, FILE *file) {
+    memset(writer, 0, sizeof(block_writer));
+    writer->file = file;
+    // the header goes in last, once the index is written
+    writer->offset = sizeof(blk_header);
+    fseek(file, (long) writer->offset, SEEK_SET);
+}
+
+int block_resume(block_writer *writer, FILE *file) {
+    memset(writer, 0, sizeof(block_writer));
+    uint64_t size = file_size(file);
+    blk_header header;
+    blk_entry *entries;
+    int result = read_index(file, size, &header, &entries);
+    if (result != 0) {
+        return result;
+    }
+    // the live bytes are the header, the blocks and the index, the rest was left behind by earlier appends
+    uint64_t live = sizeof(blk_header) + sizeof(blk_entry) * header.blocks;
+    for (uint64_t i = 0; i < header.blocks; i++) {
+        live += entries[i].packed;
+    }
+    if (size - live > live) {
+        counted_free(entries);
+        return 1;
+    }
+    writer->file = file;
+    writer->offset = size;
+    writer->count = header.count;
+    writer->entries = entries;
+    writer->blocks = header.blocks;
+    writer->capacity = header.blocks + 1;
+    // take the last block back if it has room, the items added go after its lines
+    blk_entry *last = header.blocks > 0 ? &entries[header.blocks - 1] : NULL;
+    if (last != NULL && last->lines < BLOCK_LINES && last->size < BLOCK_BYTES) {
+        char *packed = counted_malloc(last->packed + 1);
+        writer->room = BLOCK_TEXT > last->size ? BLOCK_TEXT : last->size;
+        writer->text = counted_malloc(writer->room);
+        if (packed == NULL || writer->text == NULL) {
+            counted_free(packed);
+            counted_free(writer->text);
+            counted_free(entries);
+            memset(writer, 0, sizeof(block_writer));
+            return -1;
+        }
+        fseek(file, (long) last->offset, SEEK_SET);
+        int damaged = fread(packed, 1, last->packed, file) != last->packed || unpack_block(last, packed, writer->text) != 0;
+        library_stats.bytes_read += last->packed;
+        counted_free(packed);
+        if (damaged) {
+            counted_free(writer->text);
+            counted_free(entries);
+            memset(writer, 0, sizeof(block_writer));
+            return -1;
+        }
+        writer->used = last->size;
+        writer->lines = last->lines;
+        writer->blocks--;
+    }
+    fseek(file, (long) writer->offset, SEEK_SET);
+    return 0;
+}
+
+// compress the gathered items into a block at the end of the file and add it to the index
+// without memory for the block the writer fails, block_finish then leaves the header alone
+static void flush_block(block_writer *writer) {
+    if (writer->lines == 0) {
+        return;
+    }
+    if (writer->blocks == writer->capacity) {
+        uint64_t capacity = writer->capacity > 0 ? writer->capacity * 2 : 64;
+        blk_entry *entries = counted_realloc(writer->entries, sizeof(blk_entry) * capacity);
+        if (entries == NULL) {
+            writer->failed = 1;
+            writer->used = 0;
+            writer->lines = 0;
+            return;
+        }
+        writer->entries = entries;
+        writer->capacity = capacity;
+    }
+    char *packed = counted_malloc(lz_bound(writer->used));
+    if (packed == NULL) {
+        writer->failed = 1;
+        writer->used = 0;
+        writer->lines = 0;
+        return;
+    }
+    size_t size = lz_compress(writer->text, writer->used, packed);
+    blk_entry *entry = &writer->entries[writer->blocks++];
+    memset(entry, 0, sizeof(blk_entry));
+    entry->offset = writer->offset;
+    entry->checksum = hash_value(writer->text, writer->used);
+    entry->packed = (uint32_t) size;
+    entry->size = (uint32_t) writer->used;
+    entry->lines = writer->lines;
+    if (fwrite(packed, 1, size, writer->file) != size) {
+        writer->failed = 1;
+    }
+    counted_free(packed);
+    library_stats.bytes_written += size;
+    writer->offset += size;
+    writer->used = 0;
+    writer->lines = 0;
+}
+
+void block_add(block_writer *writer, char* value, size_t len) {
+    // a block can hold at most 4GB of text, its sizes are 32 bits
+    if (writer->failed || len >= UINT32_MAX - writer->used) {
+        writer->failed = 1;
+        return;
+    }
+    if (writer->used + len + 1 > writer->room) {
+        size_t room = writer->room > 0 ? writer->room : BLOCK_TEXT;
+        while (writer->used + len + 1 > room) {
+            room *= 2;
+        }
+        char *text = counted_realloc(writer->text, room);
+        if (text == NULL) {
+            writer->failed = 1;
+            return;
+        }
+        writer->text = text;
+        writer->room = room;
+    }
+    memcpy(writer->text + writer->used, value, len);
+    writer->used += len;
+    writer->text[writer->used++] = '\n';
+    // a value holding newlines reads back as that many more items, like it does from a plain list
+    uint32_t lines = 1 + (uint32_t) count_newlines(value, len);
+    writer->lines += lines;
+    writer->count += lines;
+    if (writer->lines >= BLOCK_LINES || writer->used >= BLOCK_BYTES) {
+        flush_block(writer);
+    }
+}
+
+int block_finish(block_writer *writer) {
+    flush_block(writer);
+    blk_header header;
+    memset(&header, 0, sizeof(blk_header));
+    memcpy(header.magic, BLOCK_MAGIC, sizeof(header.magic));
+    header.count = writer->count;
+    header.blocks = writer->blocks;
+    header.index = writer->offset;
+    if (fwrite(writer->entries, sizeof(blk_entry), writer->blocks, writer->file) != writer->blocks) {
+        writer->failed = 1;
+    }
+    // the blocks and the index reach the file before the header points at them
+    if (fflush(writer->file) != 0) {
+        writer->failed = 1;
+    }
+    fseek(writer->file, 0, SEEK_SET);
+    if (!writer->failed && fwrite(&header, sizeof(blk_header), 1, writer->file) != 1) {
+        writer->failed = 1;
+    }
+    fseek(writer->file, 0, SEEK_END);
+    library_stats.bytes_written += sizeof(blk_entry) * writer->blocks + sizeof(blk_header);
+    int failed = writer->failed;
+    counted_free(writer->text);
+    counted_free(writer->entries);
+    memset(writer, 0, sizeof(block_writer));
+    return failed ? -1 : 0;
+}
+
+int block_append(char* filename, char* value) {
+    FILE *file = fopen(filename, "r+b");
+    if (file == NULL) {
+        return 1;
+    }
+    library_stats.opens++;
+    // a damaged file is left to the loader to report
+    block_writer writer;
+    if (block_resume(&writer, file) != 0) {
+        fclose(file);
+        return 1;
+    }
+    block_add(&writer, value, strlen(value));
+    int failed = block_finish(&writer) != 0;
+    return fclose(file) != 0 || failed ? -1 : 0;
+}
@@ -0,0 +1,121 @@
+// header file for listblk.c
+
+#ifndef LISTBLK_H
+#define LISTBLK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// a block list (.lstz by convention) keeps its items in blocks of up to BLOCK_LINES lines, each compressed
+// on its own with listlz. the file starts with a blk_header, then come the blocks and after the last block
+// the block index, one blk_entry per block holding where the block is, its sizes, its line count and
+// hash_value of its text. a block's text is its items, each followed by a newline.
+// get and sizeof find their block through the index and decompress only that block, getlength reads the header.
+// an append rewrites only the last block: the new last blocks and a new index go at the end of the file
+// and then the header is pointed at them, so a reader holding the old header still finds the old blocks.
+// the bytes left behind are compacted away by a full rewrite once they outgrow the live blocks
+#define BLOCK_MAGIC "LISTBLK1"
+#define BLOCK_LINES 4096
+// a block of long lines is closed at this many bytes of text before it has its lines
+#define BLOCK_BYTES (256 * 1024)
+
+typedef struct blk_header {
+    char magic[8];
+    uint64_t count;
+    uint64_t blocks;
+    uint64_t index;
+} blk_header;
+
+typedef struct blk_entry {
+    uint64_t offset;
+    uint64_t checksum;
+    uint32_t packed;
+    uint32_t size;
+    uint32_t lines;
+    uint32_t spare;
+} blk_entry;
+
+// a block list open for reading, the header and the index are read when it is opened.
+// first[i] is the index of the first item of block i, text holds the block decompressed last
+typedef struct block_list {
+    FILE *file;
+    blk_header header;
+    blk_entry *entries;
+    uint64_t *first;
+    char *packed;
+    char *text;
+    int64_t current;
+} block_list;
+
+// a block list being written, items are gathered into text until a block is full and then compressed out
+typedef struct block_writer {
+    FILE *file;
+    uint64_t offset;
+    uint64_t count;
+    char *text;
+    size_t used;
+    size_t room;
+    uint32_t lines;
+    blk_entry *entries;
+    uint64_t blocks;
+    uint64_t capacity;
+    int failed;
+} block_writer;
+
+// check if the bytes at the start of a file are the header of a block list
+int block_magic (char* bytes, long size);
+
+// open a block list file and read its header and index
+// returns 0 on success, 1 if the file does not open or is not a block list and -1 if its index is damaged or does not fit in memory
+int block_open (char* filename, block_list *blocks);
+
+// release an open block list
+void block_close (block_list *blocks);
+
+// the number of items in a block list file, or -1 if it is not a block list
+long block_count (char* filename);
+
+// the bytes of text the items of an open block list make up
+uint64_t block_bytes (block_list *blocks);
+
+// find the item at an index, the item is not terminated so its length is returned through len.
+// the item points into the block's text and stays valid until another block is read
+// returns 0 on success, -1 if the list is empty, -2 if the index is negative, -3 if it is too big
+// and -5 if the block is damaged
+int block_item (block_list *blocks, int index, char **item, size_t *len);
+
+// get the index of a value, the blocks are decompressed one after the other until it turns up
+// returns -1 if it is not found and -5 if a block is damaged
+int block_index_of (block_list *blocks, char* value);
+
+// print the items from one index to another, both included, each followed by a newline.
+// a to past the last item stops at the last item
+// returns 0 on success, -1 if the list is empty, -2 if from is negative, -3 if it is too big or past to
+// and -5 if a block is damaged
+int block_print (block_list *blocks, int from, int to);
+
+// decompress every block of a block list that was read whole into bytes
+// returns the text of the items in a new buffer with room for a terminator and stores its size,
+// or null if the file is damaged or it ran out of memory
+char* block_unpack (char* bytes, long size, long *text_size);
+
+// start writing a new block list into an empty file
+void block_start (block_writer *writer, FILE *file);
+
+// start appending to the block list in file, its last block is taken back to be filled up and written again
+// returns 0 on success, 1 if the file is not a block list or is due for compaction and -1 if it is damaged or it ran out of memory
+int block_resume (block_writer *writer, FILE *file);
+
+// add an item, len bytes without the newline
+void block_add (block_writer *writer, char* value, size_t len);
+
+// write the last block, the index and the header, the writer is released either way
+// returns 0 on success and -1 if a write failed or it ran out of memory
+int block_finish (block_writer *writer);
+
+// append a value to a block list file without loading the list, only its last block is read and written again
+// returns 0 on success, 1 if the file is not a block list, is damaged or is due for compaction and -1 on error
+int block_append (char* filename, char* value);
+
+#endif
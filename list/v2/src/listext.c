@@ -0,0 +1,470 @@
+// external sort library
+// sorts list files bigger than the memory it is allowed: sorted runs are spilled to temporary files
+// and merged back with a heap, every file is read and written in big sequential blocks
+
+#include "listext.h"
+#include "listlib.h"
+#include "listidx.h"
+#include "listblk.h"
+#include "listscan.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a run file being merged
+// the current line is line, line_len bytes long, and key is its number for a numeric sort.
+// failed is set when there was no memory to grow the buffer for a long line
+typedef struct run_reader {
+    FILE *file;
+    char *buffer;
+    size_t capacity;
+    size_t pos;
+    size_t len;
+    int done;
+    char *line;
+    size_t line_len;
+    unsigned long long key;
+    int run;
+    int failed;
+} run_reader;
+
+// read a memory budget such as 512K, 64M or 2G
+size_t read_size(char* text) {
+    char *end;
+    double size = strtod(text, &end);
+    if (end == text || size <= 0) {
+        return 0;
+    }
+    switch (toupper((unsigned char) *end)) {
+        case 'G':
+            size *= 1024;
+            // fall through
+        case 'M':
+            size *= 1024;
+            // fall through
+        case 'K':
+            size *= 1024;
+            end++;
+            break;
+    }
+    if (*end != '\0' && toupper((unsigned char) *end) != 'B') {
+        return 0;
+    }
+    return (size_t) size;
+}
+
+// the name of a run file, the caller frees it. returns null if it ran out of memory
+static char* run_name(char* filename, int run) {
+    char *name = counted_malloc(strlen(filename) + 24);
+    if (name == NULL) {
+        return NULL;
+    }
+    sprintf(name, "%s.run%i", filename, run);
+    return name;
+}
+
+// write every item followed by a newline
+static int write_items_to(FILE *file, char** values, int count) {
+    for (int i = 0; i < count; i++) {
+        fputs(values[i], file);
+        fputc('\n', file);
+    }
+    return ferror(file) != 0 ? -1 : 0;
+}
+
+// sort one piece of the list and write it to a run file
+static int write_run(char* filename, int run, char** values, int count, int numbers, lex_order *order) {
+    if (numbers) {
+        int sorted = number_sort(values, count, order->ascending);
+        if (sorted != 0) {
+            return sorted == -1 ? -2 : -1;
+        }
+    }
+    else if (lex_sort(values, count, order) != 0) {
+        return -1;
+    }
+    char *name = run_name(filename, run);
+    if (name == NULL) {
+        return -1;
+    }
+    FILE *file = fopen(name, "wb");
+    counted_free(name);
+    if (file == NULL) {
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, RUN_BLOCK);
+    int result = write_items_to(file, values, count);
+    library_stats.opens++;
+    library_stats.bytes_written += ftell(file);
+    if (fclose(file) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+// delete the run files from first up to last
+static void remove_runs(char* filename, int first, int last) {
+    for (int run = first; run < last; run++) {
+        char *name = run_name(filename, run);
+        if (name != NULL) {
+            remove(name);
+            counted_free(name);
+        }
+    }
+}
+
+// read the list in pieces that fit the budget, sort each piece and write it as a run
+// returns the number of runs written, or an error code of external_sort
+static int split_runs(char* filename, int numbers, lex_order *order, size_t limit) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    // a front-offset list keeps its items after the header and the gap
+    char header[FRONT_HEADER];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    size_t got = fread(header, 1, FRONT_HEADER, file);
+    library_stats.opens++;
+    library_stats.bytes_read += got;
+    fseek(file, front_offset(header, got < FRONT_HEADER ? (long) got : size), SEEK_SET);
+
+    // half the budget holds the bytes of a piece, the rest its records while it is sorted
+    size_t capacity = limit / 2;
+    char *buffer = counted_malloc(capacity + 1);
+    size_t len = 0;
+    int values_capacity = 1024;
+    char **values = counted_malloc(sizeof(char*) * values_capacity);
+    if (buffer == NULL || values == NULL) {
+        counted_free(buffer);
+        counted_free(values);
+        fclose(file);
+        return -1;
+    }
+    int runs = 0;
+    int eof = 0;
+    int result = 0;
+    while (result == 0) {
+        // fill the buffer after the bytes carried over from the last piece
+        if (!eof) {
+            size_t read = fread(buffer + len, 1, capacity - len, file);
+            library_stats.bytes_read += read;
+            len += read;
+            eof = len < capacity;
+        }
+        if (len == 0) {
+            break;
+        }
+        // a line longer than the whole buffer makes the buffer grow, it has to fit somewhere
+        char *last = find_last_newline(buffer, len);
+        if (last == NULL && !eof) {
+            char *grown = counted_realloc(buffer, capacity * 2 + 1);
+            if (grown == NULL) {
+                result = -1;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+            continue;
+        }
+        // take whole lines while they fit in the budget, the last line of the file may not have a newline
+        char *start = buffer;
+        char *end = eof ? buffer + len : last + 1;
+        size_t used = 0;
+        int count = 0;
+        while (start < end) {
+            char *newline = find_newline(start, end - start);
+            char *stop = newline != NULL ? newline : end;
+            size_t cost = (stop - start) + 1 + RUN_ITEM_COST;
+            if (count > 0 && used + cost > limit) {
+                break;
+            }
+            used += cost;
+            // drop the carriage return of a CRLF line ending and end the item in place
+            char *item_end = stop > start && stop[-1] == '\r' ? stop - 1 : stop;
+            *item_end = '\0';
+            if (count == values_capacity) {
+                char **grown = counted_realloc(values, sizeof(char*) * values_capacity * 2);
+                if (grown == NULL) {
+                    result = -1;
+                    break;
+                }
+                values = grown;
+                values_capacity *= 2;
+            }
+            values[count++] = start;
+            start = newline != NULL ? newline + 1 : end;
+        }
+        if (result == 0 && count > 0) {
+            result = write_run(filename, runs, values, count, numbers, order);
+            if (result == 0) {
+                runs++;
+            }
+        }
+        // carry the lines that did not make it into this piece over to the next one
+        len -= start - buffer;
+        memmove(buffer, start, len);
+        if (eof && len == 0) {
+            break;
+        }
+    }
+    counted_free(values);
+    counted_free(buffer);
+    fclose(file);
+    if (result != 0) {
+        remove_runs(filename, 0, runs + 1);
+        return result;
+    }
+    return runs;
+}
+
+// move a run reader to its next line, returns 0 once the run is used up
+static int next_line(run_reader *reader, int numbers, int ascending) {
+    for (;;) {
+        char *start = reader->buffer + reader->pos;
+        char *newline = find_newline(start, reader->len - reader->pos);
+        if (newline != NULL || (reader->done && reader->pos < reader->len)) {
+            char *stop = newline != NULL ? newline : reader->buffer + reader->len;
+            *stop = '\0';
+            reader->line = start;
+            reader->line_len = stop - start;
+            reader->pos = stop - reader->buffer + 1;
+            if (numbers) {
+                long long number = 0;
+                parse_number(start, &number);
+                reader->key = number_key(number, ascending);
+            }
+            return 1;
+        }
+        if (reader->done) {
+            return 0;
+        }
+        // keep the start of the line and read the next block after it, growing the buffer for a long line
+        reader->len -= reader->pos;
+        memmove(reader->buffer, reader->buffer + reader->pos, reader->len);
+        reader->pos = 0;
+        if (reader->len == reader->capacity) {
+            char *grown = counted_realloc(reader->buffer, reader->capacity * 2 + 1);
+            if (grown == NULL) {
+                reader->failed = 1;
+                return 0;
+            }
+            reader->buffer = grown;
+            reader->capacity *= 2;
+        }
+        size_t read = fread(reader->buffer + reader->len, 1, reader->capacity - reader->len, reader->file);
+        library_stats.bytes_read += read;
+        reader->len += read;
+        reader->done = read == 0;
+    }
+}
+
+// compare the current lines of two runs, a tie goes to the earlier run so the merge is stable
+static int compare_readers(run_reader *a, run_reader *b, int numbers, lex_order *order) {
+    int result;
+    if (numbers) {
+        result = a->key < b->key ? -1 : a->key > b->key;
+    }
+    else {
+        result = lex_compare(a->line, a->line_len, b->line, b->line_len, order);
+    }
+    return result != 0 ? result : a->run - b->run;
+}
+
+// restore the heap below a position
+static void sift_down(run_reader **heap, int count, int i, int numbers, lex_order *order) {
+    for (;;) {
+        int smallest = i;
+        int left = i * 2 + 1;
+        int right = left + 1;
+        if (left < count && compare_readers(heap[left], heap[smallest], numbers, order) < 0) {
+            smallest = left;
+        }
+        if (right < count && compare_readers(heap[right], heap[smallest], numbers, order) < 0) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        run_reader *swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+// merge runs from first up to last into an open file with a heap of their current lines
+static int merge_runs_into(char* filename, int first, int last, FILE *out, int numbers, lex_order *order, size_t limit) {
+    int count = last - first;
+    run_reader *readers = counted_calloc(count, sizeof(run_reader));
+    run_reader **heap = counted_malloc(sizeof(run_reader*) * count);
+    if (readers == NULL || heap == NULL) {
+        counted_free(readers);
+        counted_free(heap);
+        return -1;
+    }
+    // share the budget between the runs and the output, in blocks no smaller than RUN_BLOCK_MIN
+    size_t block = limit / (count + 2);
+    if (block > RUN_BLOCK) {
+        block = RUN_BLOCK;
+    }
+    if (block < RUN_BLOCK_MIN) {
+        block = RUN_BLOCK_MIN;
+    }
+    int result = 0;
+    int live = 0;
+    for (int i = 0; i < count; i++) {
+        char *name = run_name(filename, first + i);
+        readers[i].file = name != NULL ? fopen(name, "rb") : NULL;
+        counted_free(name);
+        if (readers[i].file == NULL) {
+            result = -1;
+            continue;
+        }
+        library_stats.opens++;
+        readers[i].capacity = block;
+        readers[i].buffer = counted_malloc(block + 1);
+        if (readers[i].buffer == NULL) {
+            result = -1;
+            continue;
+        }
+        readers[i].run = i;
+        if (result == 0 && next_line(&readers[i], numbers, order->ascending)) {
+            heap[live++] = &readers[i];
+        }
+    }
+    if (result == 0) {
+        for (int i = live / 2 - 1; i >= 0; i--) {
+            sift_down(heap, live, i, numbers, order);
+        }
+        // write the smallest line, then move its run on and put it back in place
+        while (live > 0) {
+            run_reader *top = heap[0];
+            fwrite(top->line, 1, top->line_len, out);
+            fputc('\n', out);
+            if (!next_line(top, numbers, order->ascending)) {
+                heap[0] = heap[--live];
+            }
+            sift_down(heap, live, 0, numbers, order);
+        }
+        if (ferror(out) != 0) {
+            result = -1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (readers[i].failed) {
+            result = -1;
+        }
+        if (readers[i].file != NULL) {
+            fclose(readers[i].file);
+        }
+        counted_free(readers[i].buffer);
+    }
+    counted_free(heap);
+    counted_free(readers);
+    return result;
+}
+
+// sort a list file that may not fit in memory
+int external_sort(char* filename, int numbers, lex_order *order, size_t limit) {
+    if (limit < RUN_MEM_MIN) {
+        limit = RUN_MEM_MIN;
+    }
+    // find out the format first, the sorted list is written in the same one
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    char header[FRONT_HEADER];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    size_t got = fread(header, 1, FRONT_HEADER, file);
+    library_stats.opens++;
+    library_stats.bytes_read += got;
+    fclose(file);
+    int format = got == FRONT_HEADER && front_offset(header, size) > 0 ? FORMAT_FRONT : FORMAT_PLAIN;
+    // a binary or block list is not read in lines, it is sorted in memory
+    uint64_t count;
+    if (got == FRONT_HEADER && (binary_offset(header, size, &count) > 0 || block_magic(header, size))) {
+        return 1;
+    }
+
+    int runs = split_runs(filename, numbers, order, limit);
+    if (runs < 0) {
+        return runs;
+    }
+    if (runs == 0) {
+        return 1;
+    }
+    // merge groups of neighbouring runs into bigger runs until one merge can take all of them,
+    // the new runs keep the order of the groups so items that tie still come out in list order
+    int first = 0;
+    while (runs - first > RUN_MERGE_MAX) {
+        int next = runs;
+        for (int group = first; group < runs; group += RUN_MERGE_MAX) {
+            int last = group + RUN_MERGE_MAX < runs ? group + RUN_MERGE_MAX : runs;
+            char *name = run_name(filename, next);
+            FILE *out = name != NULL ? fopen(name, "wb") : NULL;
+            counted_free(name);
+            int result = -1;
+            if (out != NULL) {
+                setvbuf(out, NULL, _IOFBF, RUN_BLOCK);
+                result = merge_runs_into(filename, group, last, out, numbers, order, limit);
+                library_stats.opens++;
+                library_stats.bytes_written += ftell(out);
+                if (fclose(out) != 0) {
+                    result = -1;
+                }
+            }
+            remove_runs(filename, group, last);
+            next++;
+            if (result != 0) {
+                remove_runs(filename, last, next);
+                return -1;
+            }
+        }
+        first = runs;
+        runs = next;
+    }
+    // the last merge writes the sorted list next to the list file and then replaces it,
+    // following a symbolic link and keeping the mode like write_list
+    char *target = resolve_list(filename);
+    char *temp = target != NULL ? counted_malloc(strlen(target) + 5) : NULL;
+    if (temp == NULL) {
+        counted_free(target);
+        remove_runs(filename, first, runs);
+        return -1;
+    }
+    strcpy(temp, target);
+    strcat(temp, ".tmp");
+    FILE *out = fopen(temp, "wb");
+    int result = -1;
+    if (out != NULL) {
+        keep_mode(out, target);
+        setvbuf(out, NULL, _IOFBF, RUN_BLOCK);
+        write_header(out, format);
+        result = merge_runs_into(filename, first, runs, out, numbers, order, limit);
+        library_stats.opens++;
+        library_stats.bytes_written += ftell(out);
+        if (fclose(out) != 0) {
+            result = -1;
+        }
+    }
+    remove_runs(filename, first, runs);
+    if (result == 0 && replace_file(temp, target) != 0) {
+        result = -1;
+    }
+    if (result != 0) {
+        remove(temp);
+    }
+    counted_free(temp);
+    counted_free(target);
+    if (result == 0) {
+        // every line moved, the sidecars are rebuilt the next time they are needed
+        index_drop(filename);
+    }
+    return result;
+}
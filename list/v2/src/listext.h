@@ -0,0 +1,30 @@
+// header file for listext.c
+
+#ifndef LISTEXT_H
+#define LISTEXT_H
+
+#include "listsort.h"
+#include <stddef.h>
+
+// bytes read from or written to a run file at a time, a merge of many runs reads smaller blocks
+// from each of them so the blocks fit in the budget
+#define RUN_BLOCK (1024 * 1024)
+#define RUN_BLOCK_MIN (64 * 1024)
+// the most runs merged at once, more runs are merged into bigger runs first
+#define RUN_MERGE_MAX 128
+// what every item costs in memory on top of its bytes while a run is sorted
+#define RUN_ITEM_COST 64
+// the smallest budget that is accepted, anything less is raised to this
+#define RUN_MEM_MIN (1024 * 1024)
+
+// sort a list file that may not fit in memory
+// the list is read in pieces that fit in limit bytes, each piece is sorted and written to a run file
+// next to the list and the runs are merged back into the list file.
+// numbers are sorted by value with ascending taken from order, anything else in the order of order.
+// returns 0 on success, 1 if the list is empty, a binary list or a block list, -1 on a file error and -2 if a numeric sort meets a non-integer
+int external_sort (char* filename, int numbers, lex_order *order, size_t limit);
+
+// read a memory budget such as 512K, 64M or 2G, returns 0 if it is not one
+size_t read_size (char* text);
+
+#endif
@@ -0,0 +1,88 @@
+// value table library
+// an open addressing hash table of values, so commands that look up many values
+// make one pass over the list instead of one pass per value
+
+#include "listhash.h"
+#include "liststat.h"
+#include <stdlib.h>
+#include <string.h>
+
+// hash the bytes of a value with 64 bit FNV-1a
+uint64_t hash_value(char* value, size_t len) {
+    return hash_more(HASH_SEED, value, len);
+}
+
+// carry a hash on over more bytes
+uint64_t hash_more(uint64_t hash, char* value, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char) value[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// create a table with room for a number of distinct values
+hash_table* new_table(int values) {
+    // keep the table at most half full, the slot count is a power of two so the mask picks the slot
+    size_t size = 16;
+    while (size < (size_t) values * 2) {
+        size *= 2;
+    }
+    hash_table *table = counted_malloc(sizeof(hash_table));
+    if (table == NULL) {
+        return NULL;
+    }
+    table->slots = counted_calloc(size, sizeof(hash_slot));
+    if (table->slots == NULL) {
+        counted_free(table);
+        return NULL;
+    }
+    table->mask = size - 1;
+    table->used = 0;
+    return table;
+}
+
+// free a table, the values it points at are left alone
+void free_table(hash_table *table) {
+    if (table == NULL) {
+        return;
+    }
+    counted_free(table->slots);
+    counted_free(table);
+}
+
+// walk the probe sequence of a value until we find it or reach an empty slot
+static hash_slot* probe(hash_table *table, char* value, size_t len, uint64_t hash) {
+    size_t i = hash & table->mask;
+    for (;;) {
+        hash_slot *slot = &table->slots[i];
+        if (slot->value == NULL) {
+            return slot;
+        }
+        // the hash and the length rule out almost every other value before the bytes are compared
+        if (slot->hash == hash && slot->len == len && memcmp(slot->value, value, len) == 0) {
+            return slot;
+        }
+        i = (i + 1) & table->mask;
+    }
+}
+
+// find the slot of a value, returns null if the value is not in the table
+hash_slot* table_find(hash_table *table, char* value, size_t len) {
+    hash_slot *slot = probe(table, value, len, hash_value(value, len));
+    return slot->value != NULL ? slot : NULL;
+}
+
+// find the slot of a value, adding the value if it is not in the table yet
+hash_slot* table_add(hash_table *table, char* value, size_t len) {
+    uint64_t hash = hash_value(value, len);
+    hash_slot *slot = probe(table, value, len, hash);
+    if (slot->value == NULL) {
+        slot->value = value;
+        slot->len = len;
+        slot->hash = hash;
+        slot->count = 0;
+        slot->index = -1;
+        table->used++;
+    }
+    return slot;
+}
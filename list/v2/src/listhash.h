@@ -0,0 +1,51 @@
+// header file for listhash.c
+
+#ifndef LISTHASH_H
+#define LISTHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// a slot of a value table
+// value points at a value owned by someone else, null marks an empty slot.
+// count and index are free for the caller, for example how often a value was asked for and where it was first seen
+typedef struct hash_slot {
+    char* value;
+    size_t len;
+    uint64_t hash;
+    int count;
+    int index;
+} hash_slot;
+
+// an open addressing table of values with linear probing
+// the table is sized up front for the number of values it will hold and never grows,
+// it stays at most half full so a miss ends after a short probe
+typedef struct hash_table {
+    hash_slot *slots;
+    size_t mask;
+    int used;
+} hash_table;
+
+// hash the bytes of a value
+uint64_t hash_value (char* value, size_t len);
+
+// the hash of no bytes, hash_more carries on from it
+#define HASH_SEED 14695981039346656037ULL
+
+// carry a hash on over more bytes, hashing a value in pieces gives the same hash as hashing it whole
+uint64_t hash_more (uint64_t hash, char* value, size_t len);
+
+// create a table with room for a number of distinct values, returns null if it ran out of memory
+hash_table* new_table (int values);
+
+// free a table, the values it points at are left alone
+void free_table (hash_table *table);
+
+// find the slot of a value, returns null if the value is not in the table
+hash_slot* table_find (hash_table *table, char* value, size_t len);
+
+// find the slot of a value, adding the value if it is not in the table yet
+// the table must have been created with room for every value added to it, a new slot starts with count and index set to 0 and -1
+hash_slot* table_add (hash_table *table, char* value, size_t len);
+
+#endif
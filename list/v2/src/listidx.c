@@ -0,0 +1,465 @@
+// line index library
+// keeps a sidecar file next to a list file with the offset of every IDX_STRIDE-th line,
+// so get and sizeof on a big list seek close to the line instead of scanning the whole file
+
+#include "listidx.h"
+#include "listhash.h"
+#include "listlib.h"
+#include "listscan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// the name of one of a list file's sidecars, the caller frees it. returns null if it ran out of memory
+static char* index_name(char* filename, char* suffix) {
+    char *name = counted_malloc(strlen(filename) + strlen(suffix) + 1);
+    if (name == NULL) {
+        return NULL;
+    }
+    strcpy(name, filename);
+    strcat(name, suffix);
+    return name;
+}
+
+// write a sidecar under a name of its own and rename it into place
+// readers build sidecars without taking the list's lock, so two of them may write the same one at once
+// and a reader must never open a half written one. one that cannot be written only costs speed
+static void index_write(char* filename, char* suffix, idx_header *header, void *entries, size_t size) {
+    char *name = index_name(filename, suffix);
+    char *temp = name != NULL ? counted_malloc(strlen(name) + 32) : NULL;
+    if (temp == NULL) {
+        counted_free(name);
+        return;
+    }
+    sprintf(temp, "%s.%d.tmp", name, (int) getpid());
+    FILE *file = fopen(temp, "wb");
+    if (file != NULL) {
+        library_stats.opens++;
+        library_stats.bytes_written += sizeof(idx_header) + size;
+        int failed = fwrite(header, sizeof(idx_header), 1, file) != 1 || fwrite(entries, 1, size, file) != size;
+        if (fclose(file) != 0 || failed || replace_file(temp, name) != 0) {
+            remove(temp);
+        }
+    }
+    counted_free(temp);
+    counted_free(name);
+}
+
+// hash the bytes at both ends of a mapped list file
+// a change to the header, the front or the back of the list shows up even on a file system with coarse times
+static uint64_t index_checksum(list_map *map) {
+    uint64_t hash = 14695981039346656037ULL;
+    char *bytes = map->base;
+    size_t head = map->length < IDX_CHECK_BYTES ? map->length : IDX_CHECK_BYTES;
+    size_t tail = map->length - head < IDX_CHECK_BYTES ? map->length - head : IDX_CHECK_BYTES;
+    for (size_t i = 0; i < head; i++) {
+        hash = (hash ^ (unsigned char) bytes[i]) * 1099511628211ULL;
+    }
+    for (size_t i = map->length - tail; i < map->length; i++) {
+        hash = (hash ^ (unsigned char) bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// describe the mapped list file
+// the times and the inode come from the descriptor the file was mapped through, the name could already
+// lead to a newer file that was renamed over it. windows does not rename over a file that is open without
+// delete sharing, so the name still leads to the mapped file there
+// the sub-second parts of the times and the inode are left at 0 where the platform has none
+static int index_describe(char* filename, char* magic, list_map *map, idx_header *header) {
+    struct stat st;
+#ifdef _WIN32
+    int failed = stat(filename, &st) != 0;
+#else
+    (void) filename;
+    int failed = fstat(map->fd, &st) != 0;
+#endif
+    if (failed) {
+        return -1;
+    }
+    memcpy(header->magic, magic, sizeof(header->magic));
+    header->size = map->length;
+    header->mtime = st.st_mtime;
+    header->ctime = st.st_ctime;
+#if defined(__linux__)
+    header->mtime_nsec = st.st_mtim.tv_nsec;
+    header->ctime_nsec = st.st_ctim.tv_nsec;
+#elif defined(__APPLE__)
+    header->mtime_nsec = st.st_mtimespec.tv_nsec;
+    header->ctime_nsec = st.st_ctimespec.tv_nsec;
+#else
+    header->mtime_nsec = 0;
+    header->ctime_nsec = 0;
+#endif
+#ifdef _WIN32
+    header->inode = 0;
+#else
+    header->inode = st.st_ino;
+#endif
+    header->checksum = index_checksum(map);
+    return 0;
+}
+
+// open a sidecar of a list file and check that it still matches the mapped file
+// returns null if there is no sidecar or it is stale
+static FILE* index_open(char* filename, char* suffix, char* magic, list_map *map, idx_header *header) {
+    char *name = index_name(filename, suffix);
+    if (name == NULL) {
+        return NULL;
+    }
+    FILE *file = fopen(name, "rb");
+    counted_free(name);
+    if (file == NULL) {
+        return NULL;
+    }
+    library_stats.opens++;
+    library_stats.bytes_read += sizeof(idx_header);
+    idx_header now;
+    if (fread(header, sizeof(idx_header), 1, file) != 1 || index_describe(filename, magic, map, &now) != 0 ||
+        memcmp(header->magic, magic, sizeof(header->magic)) != 0 || header->stride == 0 ||
+        header->size != now.size || header->mtime != now.mtime || header->mtime_nsec != now.mtime_nsec ||
+        header->ctime != now.ctime || header->ctime_nsec != now.ctime_nsec || header->inode != now.inode ||
+        header->checksum != now.checksum) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+// build the sidecar by scanning the mapped file once
+static int index_build(char* filename, list_map *map, idx_header *header) {
+    if (index_describe(filename, IDX_MAGIC, map, header) != 0) {
+        return -1;
+    }
+    header->stride = IDX_STRIDE;
+    header->skip = 0;
+    header->count = 0;
+    size_t capacity = 1024;
+    size_t entries = 0;
+    uint64_t *offsets = counted_malloc(sizeof(uint64_t) * capacity);
+    if (offsets == NULL) {
+        return -1;
+    }
+    char *pos = map->data;
+    char *end = map->data + map->size;
+    while (pos < end) {
+        // remember where every stride-th line starts
+        if (header->count % IDX_STRIDE == 0) {
+            if (entries == capacity) {
+                capacity *= 2;
+                uint64_t *grown = counted_realloc(offsets, sizeof(uint64_t) * capacity);
+                if (grown == NULL) {
+                    counted_free(offsets);
+                    return -1;
+                }
+                offsets = grown;
+            }
+            offsets[entries++] = pos - (char *) map->base;
+        }
+        header->count++;
+        char *newline = find_newline(pos, end - pos);
+        if (newline == NULL) {
+            break;
+        }
+        pos = newline + 1;
+    }
+    index_write(filename, IDX_SUFFIX, header, offsets, sizeof(uint64_t) * entries);
+    counted_free(offsets);
+    return 0;
+}
+
+// find the item at an index through the sidecar
+int index_item(char* filename, list_map *map, int index, char **item, size_t *len) {
+    // a binary list is its own line index
+    if (map->offsets != NULL) {
+        return map_item(map, index, item, len);
+    }
+    if (map->length < IDX_MIN_SIZE) {
+        return -4;
+    }
+    // if the list is empty, return -1
+    if (map->size == 0) {
+        return -1;
+    }
+    // if the index is negative, return -2
+    if (index < 0) {
+        return -2;
+    }
+    idx_header header;
+    FILE *file = index_open(filename, IDX_SUFFIX, IDX_MAGIC, map, &header);
+    if (file == NULL) {
+        // an item near the front is found by walking to it, that is cheaper than building the sidecar
+        int found = map_item_within(map, index, IDX_SCAN_BYTES, item, len);
+        if (found != -4) {
+            return found;
+        }
+        if (index_build(filename, map, &header) != 0) {
+            return -4;
+        }
+        file = index_open(filename, IDX_SUFFIX, IDX_MAGIC, map, &header);
+        if (file == NULL) {
+            return -4;
+        }
+    }
+    // if the index is larger than the list, return -3
+    if ((uint64_t) index >= header.count) {
+        fclose(file);
+        return -3;
+    }
+    // read the offset of the closest indexed line at or before the one we want
+    uint64_t line = index + header.skip;
+    uint64_t offset;
+    fseek(file, sizeof(idx_header) + sizeof(uint64_t) * (line / header.stride), SEEK_SET);
+    int got = fread(&offset, sizeof(uint64_t), 1, file);
+    library_stats.bytes_read += got * sizeof(uint64_t);
+    fclose(file);
+    if (got != 1 || offset > map->length) {
+        return -4;
+    }
+    // walk the few lines from there
+    // popping from a front-offset list only moves the offset in its header past the popped lines, their bytes stay
+    // where they were in front of the first item. an indexed line that now lies in front of the first item is
+    // no longer in the list, so the walk starts at the first item instead
+    char *pos = (char *) map->base + offset;
+    char *end = (char *) map->base + map->length;
+    uint64_t walk = line % header.stride;
+    if (pos < map->data) {
+        pos = map->data;
+        walk = index;
+    }
+    for (uint64_t i = 0; i < walk; i++) {
+        char *newline = find_newline(pos, end - pos);
+        if (newline == NULL) {
+            return -4;
+        }
+        pos = newline + 1;
+    }
+    char *newline = find_newline(pos, end - pos);
+    *item = pos;
+    *len = (newline != NULL ? newline : end) - pos;
+    // drop the carriage return of a CRLF line ending
+    if (*len > 0 && pos[*len - 1] == '\r') {
+        (*len)--;
+    }
+    return 0;
+}
+
+// count the items through the sidecar
+int index_length(char* filename, list_map *map) {
+    if (map->offsets != NULL) {
+        return (int) map->count;
+    }
+    idx_header header;
+    FILE *file = index_open(filename, IDX_SUFFIX, IDX_MAGIC, map, &header);
+    if (file == NULL) {
+        return -1;
+    }
+    fclose(file);
+    return header.count;
+}
+
+// delete the sidecars of a list file
+// one left behind because there was no memory for its name is stale and turned down when it is opened
+void index_drop(char* filename) {
+    char *name = index_name(filename, IDX_SUFFIX);
+    if (name != NULL) {
+        remove(name);
+        counted_free(name);
+    }
+    name = index_name(filename, HIX_SUFFIX);
+    if (name != NULL) {
+        remove(name);
+        counted_free(name);
+    }
+}
+
+// bring an existing sidecar up to date after a list file was changed at its ends
+void index_update(char* filename, long old_size, int front, int back, long *appended, int added) {
+    // the value index is not kept in step, a change at either end moves or adds first occurrences
+    char *name = index_name(filename, HIX_SUFFIX);
+    if (name != NULL) {
+        remove(name);
+        counted_free(name);
+    }
+    name = index_name(filename, IDX_SUFFIX);
+    if (name == NULL) {
+        return;
+    }
+    FILE *file = fopen(name, "r+b");
+    counted_free(name);
+    if (file == NULL) {
+        return;
+    }
+    library_stats.opens++;
+    library_stats.bytes_read += sizeof(idx_header);
+    idx_header header;
+    list_map map;
+    // the sidecar has to describe the file as it was before the change
+    if (fread(&header, sizeof(idx_header), 1, file) != 1 || header.size != (uint64_t) old_size ||
+        header.stride == 0 || header.count < (uint64_t) (front + back) || map_list(filename, &map) != 0) {
+        fclose(file);
+        index_drop(filename);
+        return;
+    }
+    // lines popped from the back are simply no longer counted, new lines are indexed where they land
+    uint64_t kept = header.skip + header.count - back;
+    for (int i = 0; i < added; i++) {
+        uint64_t line = kept + i;
+        if (line % header.stride == 0) {
+            uint64_t offset = appended[i];
+            fseek(file, sizeof(idx_header) + sizeof(uint64_t) * (line / header.stride), SEEK_SET);
+            fwrite(&offset, sizeof(uint64_t), 1, file);
+        }
+    }
+    header.skip += front;
+    header.count = kept + added - header.skip;
+    index_describe(filename, IDX_MAGIC, &map, &header);
+    unmap_list(&map);
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(idx_header), 1, file);
+    library_stats.bytes_written += sizeof(idx_header);
+    fclose(file);
+}
+
+// build the value sidecar by hashing every item of the mapped file once
+// a value that is in the list more than once only keeps its first line, like find
+static int index_build_values(char* filename, list_map *map, idx_header *header) {
+    if (index_describe(filename, HIX_MAGIC, map, header) != 0) {
+        return -1;
+    }
+    // count the lines first so the table can be sized, at most half full
+    uint64_t lines = count_lines(map->data, map->size);
+    char *pos;
+    char *end = map->data + map->size;
+    uint64_t slots = 16;
+    while (slots < lines * 2) {
+        slots *= 2;
+    }
+    header->stride = slots;
+    header->skip = 0;
+    header->count = lines;
+    hix_entry *entries = counted_calloc(slots, sizeof(hix_entry));
+    // where each entry's item starts, only needed to compare values while building
+    char **starts = counted_malloc(sizeof(char*) * slots);
+    if (entries == NULL || starts == NULL) {
+        counted_free(entries);
+        counted_free(starts);
+        return -1;
+    }
+    pos = map->data;
+    for (uint64_t line = 0; line < lines; line++) {
+        char *newline = find_newline(pos, end - pos);
+        char *stop = newline != NULL ? newline : end;
+        size_t len = stop - pos;
+        // drop the carriage return of a CRLF line ending
+        if (len > 0 && pos[len - 1] == '\r') {
+            len--;
+        }
+        uint64_t hash = hash_value(pos, len);
+        uint32_t tag = (uint32_t) (hash >> 32);
+        uint64_t i = hash & (slots - 1);
+        for (;;) {
+            if (entries[i].line == 0) {
+                entries[i].tag = tag;
+                entries[i].line = (uint32_t) line + 1;
+                starts[i] = pos;
+                break;
+            }
+            // a repeat of a value already in the table keeps the earlier line
+            if (entries[i].tag == tag) {
+                char *other = starts[i];
+                char *other_stop = find_newline(other, end - other);
+                size_t other_len = (other_stop != NULL ? other_stop : end) - other;
+                if (other_len > 0 && other[other_len - 1] == '\r') {
+                    other_len--;
+                }
+                if (other_len == len && memcmp(other, pos, len) == 0) {
+                    break;
+                }
+            }
+            i = (i + 1) & (slots - 1);
+        }
+        pos = stop + 1;
+    }
+    counted_free(starts);
+    index_write(filename, HIX_SUFFIX, header, entries, sizeof(hix_entry) * slots);
+    counted_free(entries);
+    return 0;
+}
+
+// find the index of a value through the value sidecar
+int index_find(char* filename, list_map *map, char* value) {
+    if (map->length < IDX_MIN_SIZE) {
+        return -4;
+    }
+    idx_header header;
+    FILE *file = index_open(filename, HIX_SUFFIX, HIX_MAGIC, map, &header);
+    if (file == NULL) {
+        // a value near the front is found by scanning for it, that is cheaper than building the sidecar
+        int found = map_index_within(map, value, IDX_SCAN_BYTES);
+        if (found != -4) {
+            return found;
+        }
+        if (index_build_values(filename, map, &header) != 0) {
+            return -4;
+        }
+        file = index_open(filename, HIX_SUFFIX, HIX_MAGIC, map, &header);
+        if (file == NULL) {
+            return -4;
+        }
+    }
+    // the table size is a power of two, anything else is not a table we wrote
+    uint64_t slots = header.stride;
+    if ((slots & (slots - 1)) != 0) {
+        fclose(file);
+        return -4;
+    }
+    size_t value_len = strlen(value);
+    uint64_t hash = hash_value(value, value_len);
+    uint32_t tag = (uint32_t) (hash >> 32);
+    uint64_t i = hash & (slots - 1);
+    // probe the table a run of entries at a time, a miss ends at the first empty entry
+    hix_entry run[64];
+    int result = -1;
+    for (uint64_t probed = 0; probed < slots; ) {
+        fseek(file, sizeof(idx_header) + sizeof(hix_entry) * i, SEEK_SET);
+        size_t want = slots - i < 64 ? slots - i : 64;
+        size_t got = fread(run, sizeof(hix_entry), want, file);
+        library_stats.bytes_read += got * sizeof(hix_entry);
+        if (got == 0) {
+            result = -4;
+            break;
+        }
+        int done = 0;
+        for (size_t j = 0; j < got && !done; j++) {
+            if (run[j].line == 0) {
+                done = 1;
+            }
+            // a matching tag is checked against the item itself through the line index
+            else if (run[j].tag == tag) {
+                char *item;
+                size_t len;
+                int line = run[j].line - 1;
+                if (index_item(filename, map, line, &item, &len) == 0 && len == value_len && memcmp(item, value, len) == 0) {
+                    result = line;
+                    done = 1;
+                }
+            }
+        }
+        if (done) {
+            break;
+        }
+        probed += got;
+        i = (i + got) & (slots - 1);
+    }
+    fclose(file);
+    return result;
+}
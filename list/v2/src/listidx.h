@@ -0,0 +1,75 @@
+// header file for listidx.c
+
+#ifndef LISTIDX_H
+#define LISTIDX_H
+
+#include "listmap.h"
+#include <stdint.h>
+
+// the line index sidecar, <listfile>.idx
+// it holds the file offset of every IDX_STRIDE-th line so get and sizeof can seek close to any line.
+// the lines are counted from where the list started when the index was built, skip lines have since
+// been popped from the front and count lines make up the list now.
+// size, the modification and change times to the nanosecond, the inode and checksum describe the list file
+// the index belongs to, an index that does not match is rebuilt. the change time cannot be set back,
+// so an edit that keeps the size and restores the modification time still shows up in it.
+#define IDX_MAGIC "LISTIDX2"
+#define IDX_SUFFIX ".idx"
+#define IDX_STRIDE 16
+// smaller lists are scanned instead, reading them costs less than the index
+#define IDX_MIN_SIZE (1024 * 1024)
+// without an up to date sidecar the first this many bytes of a bigger list are scanned for the answer first,
+// the sidecar is only built when the answer lies further in, so a look at the head of a queue never builds one
+#define IDX_SCAN_BYTES (1024 * 1024)
+// the checksum covers this many bytes at both ends of the list file
+#define IDX_CHECK_BYTES 4096
+
+// the value index sidecar, <listfile>.hix
+// an open addressing table with one entry per distinct value, holding the top half of the value's hash
+// and its first line plus one, 0 marks an empty entry. find checks a matching entry against the item through
+// the line index. it shares the header of the line index, stride is the number of entries in the table
+#define HIX_MAGIC "LISTHIX2"
+#define HIX_SUFFIX ".hix"
+
+typedef struct hix_entry {
+    uint32_t tag;
+    uint32_t line;
+} hix_entry;
+
+typedef struct idx_header {
+    char magic[8];
+    uint64_t size;
+    int64_t mtime;
+    int64_t mtime_nsec;
+    int64_t ctime;
+    int64_t ctime_nsec;
+    uint64_t inode;
+    uint64_t checksum;
+    uint64_t stride;
+    uint64_t skip;
+    uint64_t count;
+} idx_header;
+
+// find the item at an index through the sidecar, building the sidecar first if it is missing or stale
+// and the item is not in the first IDX_SCAN_BYTES of the list
+// returns the same codes as map_item, or -4 if the list is too small to be worth indexing
+int index_item (char* filename, list_map *map, int index, char **item, size_t *len);
+
+// find the index of a value through the value sidecar, building it first if it is missing or stale
+// and the value is not in the first IDX_SCAN_BYTES of the list
+// returns -1 if the value is not in the list, or -4 if the list is too small to be worth indexing
+int index_find (char* filename, list_map *map, char* value);
+
+// count the items through the sidecar, returns -1 if there is no up to date sidecar
+int index_length (char* filename, list_map *map);
+
+// bring an existing sidecar up to date after a list file was changed at its ends
+// old_size is the size of the list file before the change, front and back count the lines popped from each end
+// and appended holds the offsets of the lines added at the end. a sidecar that does not match old_size is dropped,
+// the value sidecar is always dropped.
+void index_update (char* filename, long old_size, int front, int back, long *appended, int added);
+
+// delete the sidecars of a list file, they are rebuilt the next time they are needed
+void index_drop (char* filename);
+
+#endif
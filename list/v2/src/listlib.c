@@ -1,554 +1,1736 @@
-
-// linked list library
-// a variety of helper functions for linked lists
-// By Zeek Halkyr
-// 2/5/22
-// "head" is a pointer to the first node in the list
-// "value" is the value to be stored in the new node
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-
-// the node has a value and a pointer to the next node
-typedef struct node {
-    char* value;
-    struct node *next;
-} node;
-
-// get the length of the list
-int length(node *head) {
-    // if the list is empty, return 0
-    if (head == NULL) {
-        return 0;
-    }
-    // otherwise, find the length
-    int length = 0;
-    while (head->next != NULL) {
-        head = head->next;
-        length++;
-    }
-    return length + 1;
-}
-
-
-// create a new node
-node *create_node(char* value) {
-    // allocate memory for the node
-    node *new_node = (node *) malloc(sizeof(node));
-    // set the value of the node, duplicate the string
-    new_node->value = strdup(value);
-    new_node->next = NULL;
-    // return the new node
-    return new_node;
-}
-
-// append a value to the end of the list
-// it takes in a head and the value
-// use create_node to create the new node
-void append(node **head, char* value) {
-    // create a new node with the value
-    node *new_node = create_node(value);
-    // if the list is empty, set the head to the new node
-    if (*head == NULL) {
-        *head = new_node;
-        return;
-    }
-    // otherwise, find the last node
-    node *current = *head;
-    while (current->next != NULL) {
-        current = current->next;
-    }
-    // set the last node's next to the new node
-    current->next = new_node;
-    return;
-}
-
-// add a new node to the beginning of the list
-void push(node **head, char* value) {
-    // create a new node with the value
-    node *new_node = create_node(value);
-    // set the new node's next to the current head
-    new_node->next = *head;
-    // set the head to the new node
-    *head = new_node;
-}
-
-
-// remove the first node from the list and return its value
-// if the list is empty, return -1
-char* pop(node **head) {
-    // if the list is empty, return -1
-    if (*head == NULL) {
-        return NULL;
-    }
-    // save the value of the first node
-    node *temp = *head;
-    // set the head to the next node
-    *head = (*head)->next;
-    char* value = temp->value;
-    // free the memory of the first node
-    free(temp);
-    return value;
-}
-
-// create a list from a file
-// the file should contain one value per line, separated by newlines
-// the newline is removed from the value, we can add it later.
-node* create_list(char* filename) {
-    // create a new list head
-    node *head = NULL;
-    // open the file, if it doesnt exist create it
-    FILE *file = fopen(filename, "r");
-    
-    // check that the file opened, if it didnt open return null
-    if (file == NULL) {
-        return NULL;
-    }
-    
-    // read the file line by line
-    char line[1024];
-    while (fgets(line, sizeof(line), file) != NULL) {
-        // if there is a newline character at the end of the line, remove it
-        if (line[strlen(line) - 1] == '\n') {
-            line[strlen(line) - 1] = '\0';
-        }
-        // append the value to the list
-        append(&head, line);
-    }
-    // close the file
-    fclose(file);
-    // return the list
-    return head;
-}
-
-
-
-// export a list to a file
-// the file should contain one value per line, separated by newlines
-// the file is automatically cleared on export
-void export_list(node* head, char* filename) {
-    // open the file
-    FILE *file = fopen(filename, "w");
-
-    // check that the file opened
-    if (file == NULL) {
-        // if it didn't open just return since we ensured it was opened earlier.
-        exit(4);
-    }
-
-
-    // write the list to the file
-    while (head != NULL) {
-        fprintf(file, "%s\n", head->value);
-        head = head->next;
-    }
-    // close the file
-    fclose(file);
-    return;
-}
-
-// remove a list item by index
-// if the index is out of bounds, return null
-// take in the list head and the index
-// it is zero indexed
-char* rem_index(node **head, int index) {
-    // if the index is out of bounds, return NULL
-    if (index < 0) {
-        return NULL;
-    }
-    // if the index is 0, pop the first item
-    if (index == 0) {
-        return pop(head);
-    }
-    // if the index is larger than the length of the list, return NULL
-    if (index > length(*head)) {
-        return NULL;
-    }
-    // otherwise, find the item at the index
-    node *current = *head;
-    for (int i = 0; i < index - 1; i++) {
-        current = current->next;
-    }
-    // save the value of the item
-    char* value = current->next->value;
-    // set the next node to the next node's next lmfao
-    current->next = current->next->next;
-    // return the value
-    return value;
-}
-
-// remove a list item by value
-// if the value is missing return null
-// take in the list head and the value
-char* rem_value(node **head, char* value) {
-    // if the list is empty, return -1
-    if (*head == NULL) {
-        return NULL;
-    }
-
-    // if there is a newline character at the end of the value, remove it
-    if (value[strlen(value) - 1] == '\n') {
-        value[strlen(value) - 1] = '\0';
-    }
-
-    // if the head's value is the value, pop the first item
-    if (strcmp((*head)->value, value) == 0) {
-        return pop(head);
-    }
-    // otherwise, find the item with the value
-    node *current = *head;
-    while (current->next != NULL) {
-        if (strcmp(current->next->value, value) == 0) {
-            break;
-        }
-        current = current->next;
-    }
-    // if the value is not found, return NULL
-    if (current->next == NULL) {
-        return NULL;
-    }
-    // save the value of the item
-    char* tvalue = current->next->value;
-    // set the next node to the next node's next lmfao
-    current->next = current->next->next;
-    // return the value
-    return tvalue;
-}
-
-
-// remove an item from the end of the list
-// it takes in a head
-// free the memory of the last node
-char* pop_end(node **head) {
-    // if the list is empty, return NULL
-    if (*head == NULL) {
-        return NULL;
-    }
-    // if the list has one item, pop the first item
-    if ((*head)->next == NULL) {
-        return pop(head);
-    }
-    // otherwise, find the last node
-    node *current = *head;
-    while (current->next->next != NULL) {
-        current = current->next;
-    }
-    // save the value of the last node
-    char* value = current->next->value;
-    // free the memory of the last node
-    free(current->next);
-    // set the last node's next to null
-    current->next = NULL;
-    // return the value
-    return value;
-}
-
-// return the index of a value in the list
-// if it is not found, return -1
-// take in the list head and the value
-int index_of(node *head, char* value) {
-    // if the list is empty, return -1
-    if (head == NULL) {
-        return -1;
-    }
-    // if the head's value is the value, return 0
-    if (strcmp(head->value, value) == 0) {
-        return 0;
-    }
-    // otherwise, find the item with the value
-    node *current = head;
-    int index = 0;
-    while (current->next != NULL) {
-        if (strcmp(current->next->value, value) == 0) {
-            return index + 1;
-        }
-        current = current->next;
-        index++;
-    }
-    // if the value is not found, return -1
-    return -1;
-}
-
-// print the index specified to the screen
-// attach a newline character to the end of the value
-int print_index(node *head, int index) {
-    // if the list is empty, return
-    if (head == NULL) {
-        return -1;
-    }
-
-    // if the index is out of bounds, return
-    if (index < 0) {
-        return -2;
-    }
-
-    // if the index is 0, print the first item
-    if (index == 0) {
-        printf("%s\n", head->value);
-        return 0;
-    }
-    // if the index is larger than the length of the list, return
-    if (index > length(head) - 1) {
-        return -3;
-    }
-    // otherwise, find the item at the index
-    node *current = head;
-    for (int i = 0; i < index - 1; i++) {
-        current = current->next;
-    }
-    // print the value of the item
-    printf("%s\n", current->next->value);
-    return 0 ;
-}
-
-// print the entire list
-// attach a newline character to the end of each value
-void print_list(node *head) {
-    // if the list is empty, return
-    if (head == NULL) {
-        printf("Empty list.\n");
-        return;
-    }
-    // print the first item
-    printf("%s\n", head->value);
-    // print the rest of the list
-    while (head->next != NULL) {
-        head = head->next;
-        // if we are at the last item in the list, print the last item without a newline
-        if (head->next == NULL) {
-            printf("%s", head->value);
-        }
-        // else print with a newline
-        else {
-            printf("%s\n", head->value);
-        }
-    }
-    return;
-}
-
-
-
-// search for an item at the index and return the value length
-// if the index is out of bounds, return -1
-// take in the list head and the index
-// the length of the string does not include the newline character
-int value_length(node *head, int index) {
-    // if the list is empty, return -1
-    if (head == NULL) {
-        return -1;
-    }
-    // if the index is out of bounds, return -1
-    if (index < 0) {
-        return -2;
-    }
-    // if the index is 0, return the length of the first item
-    if (index == 0) {
-        return strlen(head->value);
-    }
-    // if the index is larger than the length of the list, return -1
-    if (index > length(head)) {
-        return -1;
-    }
-    // otherwise, find the item at the index
-    node *current = head;
-    for (int i = 0; i < index - 1; i++) {
-        current = current->next;
-    }
-    // return the length of the value
-    return strlen(current->next->value);
-}
-
-// insert a value at the specified index
-// the existing value at the index is pushed to the right
-// take in the list head, the index, and the value
-void insert_index(node **head, int index, char* value) {
-    // if the index is out of bounds, return
-    if (index < 0) {
-        return;
-    }
-    // if the index is 0, push the first item
-    if (index == 0) {
-        push(head, value);
-        return;
-    }
-
-    // if the index is larger than the length of the list, return
-    if (index > length(*head)) {
-        printf("Could not insert at index %d\n", index);
-        return;
-    }
-    
-    // otherwise, find the item at the index
-    node *current = *head;
-    for (int i = 0; i < index - 1; i++) {
-        current = current->next;
-    }
-    // create a new node with the value
-    node *new = malloc(sizeof(node));
-    new->value = value;
-    // set the new node's next to the current node's next
-    new->next = current->next;
-    // set the current node's next to the new node
-    current->next = new;
-    return;
-}
-
-// reverse a list via recursion
-node* reverse(node *head) {
-    // if the list is empty, return
-    if (head == NULL) {
-        return NULL;
-    }
-    // if the list has one item, return the head
-    if (head->next == NULL) {
-        return head;
-    }
-    // otherwise, find the last node
-    node *current = head;
-    while (current->next->next != NULL) {
-        current = current->next;
-    }
-    // save the value of the last node
-    char* value = current->next->value;
-    // free the memory of the last node
-    free(current->next);
-    // set the last node's next to null
-    current->next = NULL;
-    // reverse the list
-    node *new = reverse(head);
-    // create a new node with the value
-    node *new_node = malloc(sizeof(node));
-    new_node->value = value;
-    // set the new node's next to the new list
-    new_node->next = new;
-    // return the new node
-    return new_node;
-}
-
-// define  comparison functions for qsort
-// one is for ascending one is for descending sort of integers
-int compare_asc(const void *a, const void *b) {
-    return *(int*)a - *(int*)b;
-}
-int compare_desc(const void *a, const void *b) {
-    return *(int*)b - *(int*)a;
-}
-// one is for ascending one is for descending sort of character strings
-// the longer string is greater than the shorter string
-int compare_asc_str(const void *a, const void *b) {
-    return strlen(*(char**)a) - strlen(*(char**)b);
-}
-int compare_desc_str(const void *a, const void *b) {
-    return strlen(*(char**)b) - strlen(*(char**)a);
-}
-
-// define a function that returns 0 if the string is not a number and 1 if it is
-// support multiple digits
-int is_number(char *str) {
-    // if the string is empty, return 0
-    if (str == NULL) {
-        return 0;
-    }
-    // if the string is not empty, check each character
-    for (int i = 0; i < strlen(str); i++) {
-        // if the character is not a digit, space, newline or tab, return 0
-        if (!isdigit(str[i]) && str[i] != ' ' && str[i] != '\n' && str[i] != '\t') {
-            return 0;
-        }
-    }
-    // if the string is a number, return 1
-    return 1;
-}
-
-// define a sort function, it takes in a list head and a boolean for ascending or descending
-// it will sort the list in ascending or descending order using qsort and create a new list containing the sorted values
-// if it encounters a non-integer it will return -1
-node* sort(node *old_list, int ascending) {
-    // if the list is empty return null
-    if (old_list == NULL) {
-        return NULL;
-    }
-
-    // if the list has only one item, return the list
-    if (old_list->next == NULL) {
-        return old_list;
-    }
-
-    // traverse the list and return -1 if there is a non-integer
-    node *current = old_list;
-    while (current != NULL) {
-        if (!is_number(current->value)) {
-            return NULL;
-        }
-        current = current->next;
-    }
-    // create a new list
-    node *new_list = NULL;
-    // create an array of integers
-    int *array = malloc(sizeof(int) * length(old_list));
-    // traverse the list and save the values in the array
-    current = old_list;
-    for (int i = 0; i < length(old_list); i++) {
-        array[i] = atoi(current->value);
-        current = current->next;
-    }
-    // sort the array
-    if (ascending) {
-        qsort(array, length(old_list), sizeof(int), compare_asc);
-    }
-    else {
-        qsort(array, length(old_list), sizeof(int), compare_desc);
-    }
-    // traverse the array and create a new list
-    for (int i = 0; i < length(old_list); i++) {
-        // create a char* for itoa
-        char *str = malloc(sizeof(char) * 24);
-        append(&new_list, itoa(array[i], str, 10));
-    }
-    // free the memory of the array
-    free(array);
-    // return the new list
-    return new_list;
-
-}
-
-node* sortstring(node* head, int ascending) {
-    // a function that sorts the list based on the length of the strings, it supports alphanumeric characters.
-    // it takes in a list head and a boolean for ascending or descending
-    // it will sort the list in ascending or descending order using qsort and create a new list containing the sorted values
-    // if the list is empty, return null
-    if (head == NULL) {
-        return NULL;
-    }
-    // if the list has only one item, return the list
-    if (head->next == NULL) {
-        return head;
-    }
-    // create a new list
-    node *new_list = NULL;
-    // create an array of strings
-    char **array = malloc(sizeof(char*) * length(head));
-    // traverse the list and save the values in the array
-    node *current = head;
-    for (int i = 0; i < length(head); i++) {
-        array[i] = current->value;
-        current = current->next;
-    }
-    // sort the array
-    if (ascending) {
-        qsort(array, length(head), sizeof(char*), compare_asc_str);
-    }
-    else {
-        qsort(array, length(head), sizeof(char*), compare_desc_str);
-    }
-    // traverse the array and create a new list
-    for (int i = 0; i < length(head); i++) {
-        append(&new_list, array[i]);
-    }
-    return new_list;
-    
-}
-
-// 
+// linked list library
+// a variety of helper functions for linked lists
+// every function works with both list engines, the linked nodes and the contiguous item array
+// By Zeek Halkyr
+// 2/5/22
+// "list" is the list handle, it tracks the head, the tail and the item count
+// "value" is the value to be stored in the new node
+
+#include "listlib.h"
+#include "listblk.h"
+#include "listidx.h"
+#include "listscan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#endif
+
+// get the length of the list
+// the handle keeps the count current so this does not walk the list
+int length(list_t *list) {
+    return list->count;
+}
+
+// add up the heap memory a list holds
+// the arena is counted whole, nodes on the spare list and values popped earlier still take up their room
+size_t list_memory(list_t *list) {
+    size_t total = sizeof(list_t);
+    if (list->buffer != NULL) {
+        total += list->size + 1;
+    }
+    for (arena_block *block = list->arena; block != NULL; block = block->next) {
+        total += sizeof(arena_block) + block->size;
+    }
+    total += sizeof(item) * list->capacity;
+    if (list->lookup != NULL) {
+        total += sizeof(hash_table) + sizeof(hash_slot) * (list->lookup->mask + 1);
+    }
+    return total;
+}
+
+// create a new empty list handle with the default engine
+// the LIST_ENGINE environment variable picks the engine at run time
+list_t* new_list(void) {
+    int engine = LIST_ENGINE;
+    char *name = getenv("LIST_ENGINE");
+    if (name != NULL && strcmp(name, "array") == 0) {
+        engine = ENGINE_ARRAY;
+    }
+    else if (name != NULL && strcmp(name, "linked") == 0) {
+        engine = ENGINE_LINKED;
+    }
+    return new_list_engine(engine);
+}
+
+// create a new empty list handle with a specific engine
+list_t* new_list_engine(int engine) {
+    list_t *list = (list_t *) counted_malloc(sizeof(list_t));
+    if (list == NULL) {
+        return NULL;
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    list->buffer = NULL;
+    list->arena = NULL;
+    list->spare = NULL;
+    list->engine = engine;
+    list->items = NULL;
+    list->first = 0;
+    list->capacity = 0;
+    list->format = FORMAT_PLAIN;
+    list->size = 0;
+    list->origin = 0;
+    list->start = 0;
+    list->end = 0;
+    list->open_end = 0;
+    list->pushed = 0;
+    list->appended = 0;
+    list->popped_front = 0;
+    list->popped_back = 0;
+    list->dirty = 0;
+    list->lookup = NULL;
+    list->lookups = 0;
+    return list;
+}
+
+// free a list handle and everything it owns in one go
+// values returned by pop and the other removal functions are freed with it
+void free_list(list_t *list) {
+    arena_block *block = list->arena;
+    while (block != NULL) {
+        arena_block *next = block->next;
+        counted_free(block);
+        block = next;
+    }
+    free_table(list->lookup);
+    counted_free(list->items);
+    counted_free(list->buffer);
+    counted_free(list);
+}
+
+// carve memory for a node or a string out of the list's arena
+// the arena grows by blocks that double in size, so a big load costs a handful of mallocs
+// returns null if there is no memory for a new block
+static void* arena_alloc(list_t *list, size_t size) {
+    // keep every allocation aligned for a node
+    size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    arena_block *block = list->arena;
+    if (block == NULL || block->size - block->used < size) {
+        size_t block_size = block == NULL ? ARENA_BLOCK : block->size * 2;
+        if (block_size > ARENA_BLOCK_MAX) {
+            block_size = ARENA_BLOCK_MAX;
+        }
+        if (block_size < size) {
+            block_size = size;
+        }
+        arena_block *new_block = counted_malloc(sizeof(arena_block) + block_size);
+        if (new_block == NULL) {
+            return NULL;
+        }
+        new_block->next = block;
+        new_block->size = block_size;
+        new_block->used = 0;
+        list->arena = new_block;
+        block = new_block;
+    }
+    void *memory = block->data + block->used;
+    block->used += size;
+    return memory;
+}
+
+// copy a string into the list's arena
+static char* arena_strdup(list_t *list, char* value) {
+    size_t len = strlen(value) + 1;
+    char *copy = arena_alloc(list, len);
+    if (copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, value, len);
+    return copy;
+}
+
+// create a node that uses the value as is instead of duplicating it
+// used for values that live in the list's file buffer or arena
+// nodes that were unlinked earlier are reused before the arena is touched
+static node *wrap_value(list_t *list, char* value) {
+    node *new_node = list->spare;
+    if (new_node != NULL) {
+        list->spare = new_node->next;
+    }
+    else {
+        new_node = arena_alloc(list, sizeof(node));
+        if (new_node == NULL) {
+            return NULL;
+        }
+    }
+    new_node->value = value;
+    new_node->next = NULL;
+    new_node->prev = NULL;
+    new_node->offset = NEW_BACK;
+    return new_node;
+}
+
+// create a new node
+node *create_node(list_t *list, char* value) {
+    // set the value of the node, duplicate the string into the arena
+    char *copy = arena_strdup(list, value);
+    return copy != NULL ? wrap_value(list, copy) : NULL;
+}
+
+// drop the value lookup table and start counting searches again, the items it points at have moved
+static void forget_lookup(list_t *list) {
+    if (list->lookup != NULL) {
+        free_table(list->lookup);
+        list->lookup = NULL;
+    }
+    list->lookups = 0;
+}
+
+// link a node in after "prev", a null prev links it in as the new head
+static void link_after(list_t *list, node *prev, node *new_node) {
+    forget_lookup(list);
+    new_node->prev = prev;
+    new_node->next = prev == NULL ? list->head : prev->next;
+    // fix up the neighbours, or the head and tail if there are none
+    if (new_node->next != NULL) {
+        new_node->next->prev = new_node;
+    }
+    else {
+        list->tail = new_node;
+    }
+    if (prev != NULL) {
+        prev->next = new_node;
+    }
+    else {
+        list->head = new_node;
+    }
+    list->count++;
+}
+
+// record what removing an item means for the file
+// prev and next are the offsets of the neighbouring items, a missing neighbour counts as a new item
+static void track_removal(list_t *list, long offset, long prev, long next) {
+    forget_lookup(list);
+    // new items have not been written yet so they only leave the pending count
+    if (offset == NEW_FRONT) {
+        list->pushed--;
+    }
+    else if (offset == NEW_BACK) {
+        list->appended--;
+    }
+    // a stored item at the back is dropped by cutting the file where it starts
+    else if (next < 0) {
+        list->popped_back++;
+        list->end = offset;
+        list->open_end = 0;
+        // if it was also the first stored item nothing is left between start and end
+        if (prev < 0) {
+            list->start = list->end;
+        }
+    }
+    // a stored item at the front moves the start of the stored items up to the next one
+    else if (prev < 0) {
+        list->popped_front++;
+        list->start = next;
+    }
+    // anything from the middle means the file has to be rewritten
+    else {
+        list->dirty = 1;
+    }
+}
+
+// unlink a node from the list, free it and return its value
+static char* unlink_node(list_t *list, node *old) {
+    track_removal(list, old->offset, old->prev != NULL ? old->prev->offset : NEW_FRONT, old->next != NULL ? old->next->offset : NEW_BACK);
+    // fix up the neighbours, or the head and tail if there are none
+    if (old->prev != NULL) {
+        old->prev->next = old->next;
+    }
+    else {
+        list->head = old->next;
+    }
+    if (old->next != NULL) {
+        old->next->prev = old->prev;
+    }
+    else {
+        list->tail = old->prev;
+    }
+    list->count--;
+    // keep the node around for the next push or append, the value stays valid until the list is freed
+    char* value = old->value;
+    old->next = list->spare;
+    list->spare = old;
+    return value;
+}
+
+// find the node at an index, walking from whichever end is closer
+// the index must be in range
+static node* node_at(list_t *list, int index) {
+    node *current;
+    if (index < list->count / 2) {
+        current = list->head;
+        for (int i = 0; i < index; i++) {
+            current = current->next;
+        }
+    }
+    else {
+        current = list->tail;
+        for (int i = list->count - 1; i > index; i--) {
+            current = current->prev;
+        }
+    }
+    return current;
+}
+
+// the array engine's item at an index
+#define SLOT(list, index) (&(list)->items[(list)->first + (index)])
+
+// make room in the item array for more items at the front and at the back
+// the array doubles when it grows and the items are re-centred so pushes and appends stay amortised O(1)
+// returns 0 on success and -1 if there is no memory for a bigger array, the items then stay where they are
+static int reserve_items(list_t *list, int front, int back) {
+    if (list->first >= front && list->capacity - list->first - list->count >= back) {
+        return 0;
+    }
+    int capacity = list->capacity > 0 ? list->capacity : 16;
+    while (capacity < list->count + front + back) {
+        capacity *= 2;
+    }
+    capacity *= 2;
+    item *items = counted_malloc(sizeof(item) * capacity);
+    if (items == NULL) {
+        return -1;
+    }
+    // put the spare room evenly at both ends, at least as much as was asked for
+    int first = (capacity - list->count - front - back) / 2 + front;
+    if (list->count > 0) {
+        memcpy(items + first, SLOT(list, 0), sizeof(item) * list->count);
+    }
+    counted_free(list->items);
+    list->items = items;
+    list->first = first;
+    list->capacity = capacity;
+    return 0;
+}
+
+// put a new item into the array engine at an index, moving whichever side is shorter
+// returns 0 on success and -1 if it ran out of memory
+static int insert_slot(list_t *list, int index, char* value, size_t len, long offset) {
+    if (reserve_items(list, index < list->count / 2, index < list->count / 2 ? 0 : 1) != 0) {
+        return -1;
+    }
+    forget_lookup(list);
+    if (index < list->count / 2) {
+        list->first--;
+        memmove(SLOT(list, 0), SLOT(list, 1), sizeof(item) * index);
+    }
+    else {
+        memmove(SLOT(list, index + 1), SLOT(list, index), sizeof(item) * (list->count - index));
+    }
+    item *slot = SLOT(list, index);
+    slot->value = value;
+    slot->len = len;
+    slot->offset = offset;
+    list->count++;
+    return 0;
+}
+
+// take an item out of the array engine and return its value, moving whichever side is shorter
+static char* remove_slot(list_t *list, int index) {
+    item *slot = SLOT(list, index);
+    track_removal(list, slot->offset, index > 0 ? slot[-1].offset : NEW_FRONT, index < list->count - 1 ? slot[1].offset : NEW_BACK);
+    char *value = slot->value;
+    if (index < list->count / 2) {
+        memmove(SLOT(list, 1), SLOT(list, 0), sizeof(item) * index);
+        list->first++;
+    }
+    else {
+        memmove(slot, slot + 1, sizeof(item) * (list->count - index - 1));
+    }
+    list->count--;
+    return value;
+}
+
+// add a value at an index, with either engine
+// the value is stored as is and offset says where it lives in the file, a null value is one that could not be copied
+// returns 0 on success and -1 if it ran out of memory
+static int insert_value(list_t *list, int index, char* value, long offset) {
+    if (value == NULL) {
+        return -1;
+    }
+    if (list->engine == ENGINE_ARRAY) {
+        return insert_slot(list, index, value, strlen(value), offset);
+    }
+    node *new_node = wrap_value(list, value);
+    if (new_node == NULL) {
+        return -1;
+    }
+    new_node->offset = offset;
+    link_after(list, index == 0 ? NULL : index == list->count ? list->tail : node_at(list, index - 1), new_node);
+    return 0;
+}
+
+// remove the value at an index, with either engine
+// the index must be in range
+static char* remove_value(list_t *list, int index) {
+    if (list->engine == ENGINE_ARRAY) {
+        return remove_slot(list, index);
+    }
+    return unlink_node(list, index == 0 ? list->head : index == list->count - 1 ? list->tail : node_at(list, index));
+}
+
+// get the value at an index, with either engine
+// the index must be in range
+static char* value_at(list_t *list, int index) {
+    if (list->engine == ENGINE_ARRAY) {
+        return SLOT(list, index)->value;
+    }
+    return node_at(list, index)->value;
+}
+
+// collect the values of the list in order into a new array, returns null if it ran out of memory
+static char** list_values(list_t *list) {
+    char **values = counted_malloc(sizeof(char*) * (list->count + 1));
+    if (values == NULL) {
+        return NULL;
+    }
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = 0; i < list->count; i++) {
+            values[i] = SLOT(list, i)->value;
+        }
+    }
+    else {
+        int i = 0;
+        for (node *current = list->head; current != NULL; current = current->next) {
+            values[i++] = current->value;
+        }
+    }
+    return values;
+}
+
+// write values back into the list in order, the list keeps its length
+static void set_values(list_t *list, char** values) {
+    forget_lookup(list);
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = 0; i < list->count; i++) {
+            SLOT(list, i)->value = values[i];
+            SLOT(list, i)->len = strlen(values[i]);
+        }
+    }
+    else {
+        int i = 0;
+        for (node *current = list->head; current != NULL; current = current->next) {
+            current->value = values[i++];
+        }
+    }
+}
+
+// write the items from one index up to another to a file and record where each one now starts
+// the offsets are also copied into the offsets array when there is one
+// returns the offset after the last item written
+static long write_items(list_t *list, FILE *file, int from, int to, long offset, long *offsets) {
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = from; i < to; i++) {
+            item *slot = SLOT(list, i);
+            fwrite(slot->value, 1, slot->len, file);
+            fputc('\n', file);
+            slot->offset = offset;
+            if (offsets != NULL) {
+                offsets[i - from] = offset;
+            }
+            offset += slot->len + 1;
+        }
+        return offset;
+    }
+    if (from == to) {
+        return offset;
+    }
+    node *current = from == 0 ? list->head : node_at(list, from);
+    for (int i = from; i < to; i++) {
+        size_t len = strlen(current->value);
+        fwrite(current->value, 1, len, file);
+        fputc('\n', file);
+        current->offset = offset;
+        if (offsets != NULL) {
+            offsets[i - from] = offset;
+        }
+        offset += len + 1;
+        current = current->next;
+    }
+    return offset;
+}
+
+// add the items from one index up to another to a block list being written and record where every item starts
+// in the text of the items, offset is where the first one starts. returns where the item after the last would start
+static long pack_items(list_t *list, block_writer *writer, int from, int to, long offset) {
+    node *current = list->engine == ENGINE_ARRAY || from == to ? NULL : node_at(list, from);
+    for (int i = from; i < to; i++) {
+        size_t len;
+        if (list->engine == ENGINE_ARRAY) {
+            item *slot = SLOT(list, i);
+            len = slot->len;
+            block_add(writer, slot->value, len);
+            slot->offset = offset;
+        }
+        else {
+            len = strlen(current->value);
+            block_add(writer, current->value, len);
+            current->offset = offset;
+            current = current->next;
+        }
+        offset += len + 1;
+    }
+    return offset;
+}
+
+// add up the bytes the items from one index up to another take in a file
+static long items_size(list_t *list, int from, int to) {
+    long size = 0;
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = from; i < to; i++) {
+            size += SLOT(list, i)->len + 1;
+        }
+        return size;
+    }
+    if (from == to) {
+        return size;
+    }
+    node *current = from == 0 ? list->head : node_at(list, from);
+    for (int i = from; i < to; i++) {
+        size += strlen(current->value) + 1;
+        current = current->next;
+    }
+    return size;
+}
+
+// append a value to the end of the list
+// it takes in the list and the value
+int append(list_t *list, char* value) {
+    // add the new item after the last one, the tail pointer or the array keeps this O(1)
+    if (insert_value(list, list->count, arena_strdup(list, value), NEW_BACK) != 0) {
+        return -1;
+    }
+    list->appended++;
+    return 0;
+}
+
+// add a new node to the beginning of the list
+int push(list_t *list, char* value) {
+    // add the new item in front of the first one
+    if (insert_value(list, 0, arena_strdup(list, value), NEW_FRONT) != 0) {
+        return -1;
+    }
+    list->pushed++;
+    return 0;
+}
+
+
+// remove the first node from the list and return its value
+// if the list is empty, return NULL
+char* pop(list_t *list) {
+    // if the list is empty, return NULL
+    if (list->count == 0) {
+        return NULL;
+    }
+    return remove_value(list, 0);
+}
+
+// add the items of a binary list in its buffer
+// every item is checked against the heap and the heap against the checksum, so a damaged file is never loaded
+// returns 0 on success and -1 if the file is damaged or it ran out of memory
+static int load_binary(list_t *list, int count) {
+    bin_header header;
+    memcpy(&header, list->buffer, sizeof(bin_header));
+    uint64_t *offsets = (uint64_t *) (list->buffer + sizeof(bin_header));
+    char *heap = list->buffer + list->start;
+    uint64_t size = list->end - list->start;
+    if (hash_more(HASH_SEED, heap, size) != header.checksum || offsets[count] != size) {
+        return -1;
+    }
+    if (list->engine == ENGINE_ARRAY && reserve_items(list, 0, count) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        uint64_t from = offsets[i];
+        uint64_t to = offsets[i + 1];
+        if (to <= from || to > size || heap[to - 1] != '\n') {
+            return -1;
+        }
+        // the newline becomes the terminator, the value stays where it is
+        heap[to - 1] = '\0';
+        if (list->engine == ENGINE_ARRAY) {
+            item *slot = SLOT(list, list->count++);
+            slot->value = heap + from;
+            slot->len = to - from - 1;
+            slot->offset = list->start + from;
+        }
+        else {
+            node *new_node = wrap_value(list, heap + from);
+            if (new_node == NULL) {
+                return -1;
+            }
+            new_node->offset = list->start + from;
+            link_after(list, list->tail, new_node);
+        }
+    }
+    return 0;
+}
+
+// create a list from a file
+// the file should contain one value per line, separated by newlines
+// the whole file is read into one buffer that the list keeps, each newline is replaced with a terminator
+// so every value points straight into the buffer and no line is copied. lines have no length limit
+// and a carriage return before the newline is dropped so CRLF files load the same as LF files.
+// returns null if the file does not open, is damaged or does not fit in memory
+list_t* create_list(char* filename) {
+    // open the file in binary mode so the size we read matches the size on disk
+    FILE *file = fopen(filename, "rb");
+
+    // check that the file opened, if it didnt open return null
+    if (file == NULL) {
+        return NULL;
+    }
+    library_stats.opens++;
+
+    // find the size of the file
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    // read the whole file in one go, with room for a terminator after the last line
+    char *buffer = counted_malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    size_t got = fread(buffer, 1, size, file);
+    library_stats.bytes_read += got;
+    // close the file
+    fclose(file);
+
+    // a block list is decompressed into the text of its items, which then loads like a plain list
+    int packed = block_magic(buffer, got);
+    if (packed) {
+        long text_size;
+        char *text = block_unpack(buffer, got, &text_size);
+        counted_free(buffer);
+        if (text == NULL) {
+            return NULL;
+        }
+        buffer = text;
+        got = text_size;
+    }
+
+    // create a new list that owns the buffer
+    list_t *list = new_list();
+    if (list == NULL) {
+        counted_free(buffer);
+        return NULL;
+    }
+    list->buffer = buffer;
+    list->size = got;
+    list->end = got;
+    list->open_end = got > 0 && buffer[got - 1] != '\n';
+    if (packed) {
+        list->format = FORMAT_BLOCKS;
+    }
+
+    // a front-offset list keeps its items after the header and the gap
+    long origin = packed ? 0 : front_offset(buffer, got);
+    if (origin > 0) {
+        list->format = FORMAT_FRONT;
+        list->origin = origin;
+        list->start = origin;
+    }
+
+    // a binary list says where every item is, its buffer is not searched for newlines
+    uint64_t count;
+    long heap = packed ? 0 : binary_offset(buffer, got, &count);
+    if (heap > 0) {
+        list->format = FORMAT_BINARY;
+        list->origin = heap;
+        list->start = heap;
+        list->open_end = 0;
+        if (load_binary(list, (int) count) != 0) {
+            free_list(list);
+            return NULL;
+        }
+        return list;
+    }
+
+    // split the buffer on newlines in one linear pass
+    char *start = buffer + list->start;
+    char *end = buffer + got;
+    // the array engine counts the lines first so the item array is allocated once
+    if (list->engine == ENGINE_ARRAY && reserve_items(list, 0, (int) count_lines(start, end - start)) != 0) {
+        free_list(list);
+        return NULL;
+    }
+    while (start < end) {
+        // find the end of this line, the last line may not have a newline
+        char *newline = find_newline(start, end - start);
+        char *stop = newline != NULL ? newline : end;
+        // drop the carriage return of a CRLF line ending
+        if (stop > start && stop[-1] == '\r') {
+            stop--;
+        }
+        *stop = '\0';
+        // add the line as the new last item without copying it
+        if (list->engine == ENGINE_ARRAY) {
+            if (reserve_items(list, 0, 1) != 0) {
+                free_list(list);
+                return NULL;
+            }
+            item *slot = SLOT(list, list->count++);
+            slot->value = start;
+            slot->len = stop - start;
+            slot->offset = start - buffer;
+        }
+        else {
+            node *new_node = wrap_value(list, start);
+            if (new_node == NULL) {
+                free_list(list);
+                return NULL;
+            }
+            new_node->offset = start - buffer;
+            link_after(list, list->tail, new_node);
+        }
+        if (newline == NULL) {
+            break;
+        }
+        start = newline + 1;
+    }
+    // return the list
+    return list;
+}
+
+
+
+// start a list file in a format
+// a front-offset list gets its header and a fresh gap of empty lines, a plain list needs nothing
+long write_header(FILE *file, int format) {
+    if (format != FORMAT_FRONT) {
+        return 0;
+    }
+    long offset = FRONT_HEADER + FRONT_GAP;
+    fprintf(file, "%s%020ld\n", FRONT_MAGIC, offset);
+    for (int i = 0; i < FRONT_GAP; i++) {
+        fputc('\n', file);
+    }
+    return offset;
+}
+
+// start a binary list file with its header and its offset table
+// the items are hashed for the header's checksum on the way, returns the offset where the heap starts
+static long write_table(list_t *list, FILE *file) {
+    bin_header header;
+    memset(&header, 0, sizeof(bin_header));
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.count = list->count;
+    header.checksum = HASH_SEED;
+    // the header goes in last, its heap size and checksum are only known once the table is written
+    fseek(file, sizeof(bin_header), SEEK_SET);
+    uint64_t offset = 0;
+    node *current = list->head;
+    for (int i = 0; i < list->count; i++) {
+        fwrite(&offset, sizeof(uint64_t), 1, file);
+        char *value;
+        size_t len;
+        if (list->engine == ENGINE_ARRAY) {
+            value = SLOT(list, i)->value;
+            len = SLOT(list, i)->len;
+        }
+        else {
+            value = current->value;
+            len = strlen(value);
+            current = current->next;
+        }
+        header.checksum = hash_more(header.checksum, value, len);
+        header.checksum = hash_more(header.checksum, "\n", 1);
+        offset += len + 1;
+    }
+    // the last offset is the end of the heap
+    fwrite(&offset, sizeof(uint64_t), 1, file);
+    header.heap = offset;
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(bin_header), 1, file);
+    fseek(file, 0, SEEK_END);
+    return sizeof(bin_header) + sizeof(uint64_t) * (list->count + 1);
+}
+
+// put a finished file in place of another, replacing it in one step
+int replace_file(char* from, char* to) {
+    library_stats.renames++;
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(from, to);
+#endif
+}
+
+// follow the symbolic links of a list file's name to the file itself
+char* resolve_list(char* filename) {
+#ifdef _WIN32
+    char *resolved = NULL;
+#else
+    char *resolved = realpath(filename, NULL);
+#endif
+    char *name = resolved != NULL ? resolved : filename;
+    char *copy = counted_malloc(strlen(name) + 1);
+    if (copy != NULL) {
+        strcpy(copy, name);
+    }
+    free(resolved);
+    return copy;
+}
+
+// give a file that is about to replace a list file the permissions and the owner of the list file
+void keep_mode(FILE *file, char* filename) {
+#ifndef _WIN32
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        return;
+    }
+    int fd = fileno(file);
+    // only root can hand a file to another user, anyone else can still keep its group
+    if (fchown(fd, st.st_uid, st.st_gid) != 0 && fchown(fd, (uid_t) -1, st.st_gid) != 0) {
+        // the new file stays with the user who wrote it
+    }
+    // the owner goes first, changing it may clear the set-user-ID and set-group-ID bits
+    fchmod(fd, st.st_mode & 07777);
+#else
+    (void) file;
+    (void) filename;
+#endif
+}
+
+// take the writer lock of a list file, waiting for the writer that holds it
+int lock_list(char* filename, list_lock *lock) {
+    char *target = resolve_list(filename);
+    char *name = target != NULL ? counted_malloc(strlen(target) + strlen(LOCK_SUFFIX) + 1) : NULL;
+    if (name == NULL) {
+        counted_free(target);
+        return -1;
+    }
+    strcpy(name, target);
+    strcat(name, LOCK_SUFFIX);
+    counted_free(target);
+#ifdef _WIN32
+    lock->handle = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    counted_free(name);
+    if (lock->handle == INVALID_HANDLE_VALUE) {
+        lock->handle = NULL;
+        return -1;
+    }
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    if (!LockFileEx(lock->handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)) {
+        CloseHandle(lock->handle);
+        lock->handle = NULL;
+        return -1;
+    }
+    library_stats.opens++;
+    library_stats.locks++;
+#else
+    lock->fd = open(name, O_RDWR | O_CREAT, 0666);
+    counted_free(name);
+    if (lock->fd < 0) {
+        return -1;
+    }
+    // a signal can cut the wait short, keep waiting
+    int result;
+    while ((result = flock(lock->fd, LOCK_EX)) != 0 && errno == EINTR) {
+    }
+    if (result != 0) {
+        close(lock->fd);
+        lock->fd = -1;
+        return -1;
+    }
+    library_stats.opens++;
+    library_stats.locks++;
+#endif
+    return 0;
+}
+
+// release the writer lock of a list file
+// the lock file stays behind, removing it would let two writers lock different files of the same name
+void unlock_list(list_lock *lock) {
+#ifdef _WIN32
+    if (lock->handle != NULL) {
+        CloseHandle(lock->handle);
+        lock->handle = NULL;
+    }
+#else
+    if (lock->fd >= 0) {
+        close(lock->fd);
+        lock->fd = -1;
+    }
+#endif
+}
+
+// write the whole list to a file and record where every item now starts
+// the file is opened in binary mode so the offsets match the bytes on disk
+// the list is written to <filename>.tmp which then replaces the file, so a reader sees the old list or the new one
+// and never a half written file. if the temporary file cannot be created the file is written in place.
+// a name that is a symbolic link is followed, the new file replaces the file it points at and keeps its mode
+static int write_list(list_t *list, char* filename) {
+    char *target = resolve_list(filename);
+    char *temp = target != NULL ? counted_malloc(strlen(target) + 5) : NULL;
+    if (temp == NULL) {
+        counted_free(target);
+        return -1;
+    }
+    strcpy(temp, target);
+    strcat(temp, ".tmp");
+    // open the file
+    FILE *file = fopen(temp, "wb");
+    if (file != NULL) {
+        keep_mode(file, target);
+    }
+    else {
+        counted_free(temp);
+        temp = NULL;
+        file = fopen(target, "wb");
+    }
+
+    // check that the file opened
+    if (file == NULL) {
+        counted_free(target);
+        return -1;
+    }
+    library_stats.opens++;
+
+    long offset = list->format == FORMAT_BINARY ? write_table(list, file) : write_header(file, list->format);
+    list->origin = offset;
+    list->start = offset;
+
+    // write the list to the file, a block list goes through a block writer that compresses it
+    int failed = 0;
+    if (list->format == FORMAT_BLOCKS) {
+        block_writer writer;
+        block_start(&writer, file);
+        offset = pack_items(list, &writer, 0, list->count, offset);
+        failed = block_finish(&writer) != 0;
+    }
+    else {
+        offset = write_items(list, file, 0, list->count, offset, NULL);
+        library_stats.bytes_written += offset;
+    }
+    // close the file
+    failed = fclose(file) != 0 || failed;
+    // put the new file in place of the old one
+    if (temp != NULL) {
+        if (failed || replace_file(temp, target) != 0) {
+            remove(temp);
+            failed = 1;
+        }
+        counted_free(temp);
+    }
+    counted_free(target);
+    if (failed) {
+        return -1;
+    }
+    // the whole list is stored now
+    list->size = offset;
+    list->end = offset;
+    list->open_end = 0;
+    list->pushed = 0;
+    list->appended = 0;
+    list->popped_front = 0;
+    list->popped_back = 0;
+    list->dirty = 0;
+    // the line index no longer matches, it is rebuilt the next time it is needed
+    index_drop(filename);
+    return 0;
+}
+
+// export a list to a file
+// the file should contain one value per line, separated by newlines
+// the file is automatically cleared on export
+// returns 0 on success and -1 if the file could not be written
+int export_list(list_t *list, char* filename) {
+    return write_list(list, filename);
+}
+
+// write the changes made to the front of a front-offset list
+// pushed items are written into the gap, then the header is updated. popped items are left where they are,
+// the bytes in front of the first item are not part of the list and a reader that read the header before
+// the pop may still be reading them
+// returns 1 if the list has to be rewritten instead
+static int save_front(list_t *list, char* filename) {
+    // add up the bytes the pushed items need
+    long need = items_size(list, 0, list->pushed);
+    long gap = list->start - FRONT_HEADER - need;
+    // rewrite if the items do not fit or the gap is big enough to compact
+    if (gap < 0 || (gap > FRONT_COMPACT && gap > list->end - list->start)) {
+        return 1;
+    }
+    // nothing changed at the front
+    if (list->pushed == 0 && list->start == list->origin) {
+        return 0;
+    }
+    FILE *file = fopen(filename, "r+b");
+    if (file == NULL) {
+        return -1;
+    }
+    library_stats.opens++;
+    library_stats.bytes_written += need + FRONT_HEADER;
+    // write the pushed items right before the stored items
+    fseek(file, list->start - need, SEEK_SET);
+    write_items(list, file, 0, list->pushed, list->start - need, NULL);
+    // point the header at the new first item
+    list->start -= need;
+    fseek(file, 0, SEEK_SET);
+    fprintf(file, "%s%020ld\n", FRONT_MAGIC, list->start);
+    if (fclose(file) != 0) {
+        return -1;
+    }
+    list->origin = list->start;
+    list->pushed = 0;
+    return 0;
+}
+
+// write the changes made to a block list
+// new items at the end fill up the last block and go on into new blocks, only the last block is written again.
+// any other change rewrites the file, and so does an append once the file is due for compaction
+static int save_blocks(list_t *list, char* filename) {
+    if (!unsaved(list)) {
+        return 0;
+    }
+    if (list->dirty || list->pushed > 0 || list->start != list->origin || list->end < list->size) {
+        return write_list(list, filename);
+    }
+    FILE *file = fopen(filename, "r+b");
+    if (file == NULL) {
+        return -1;
+    }
+    library_stats.opens++;
+    // a file that is due for compaction or no longer reads back is written again from the list
+    block_writer writer;
+    if (block_resume(&writer, file) != 0) {
+        fclose(file);
+        return write_list(list, filename);
+    }
+    long offset = pack_items(list, &writer, list->count - list->appended, list->count, list->end);
+    int failed = block_finish(&writer) != 0;
+    if (fclose(file) != 0 || failed) {
+        return -1;
+    }
+    list->size = offset;
+    list->end = offset;
+    list->appended = 0;
+    return 0;
+}
+
+// write the changes made to a list back to its file
+// a plain file is only rewritten when items were pushed, popped from the front or moved around,
+// a front-offset file only when its order changed or the front no longer fits the gap.
+// items popped from the end also rewrite the file, cutting it short under a reader that has it mapped
+// would crash the reader. otherwise new items are appended to the file in a single write
+int save_list(list_t *list, char* filename) {
+    if (list->format == FORMAT_BLOCKS) {
+        return save_blocks(list, filename);
+    }
+    // a binary list has its offset table in front of the items, any change rewrites it
+    if (list->dirty || (list->format == FORMAT_BINARY && unsaved(list))) {
+        return write_list(list, filename);
+    }
+    if (list->format == FORMAT_BINARY) {
+        return 0;
+    }
+    long old_size = list->size;
+    int pushed = list->pushed;
+    if (list->format == FORMAT_FRONT) {
+        int result = save_front(list, filename);
+        if (result != 0) {
+            return result < 0 ? result : write_list(list, filename);
+        }
+    }
+    // the stored items have to start a plain file for an in place update
+    else if (list->pushed > 0 || list->start != 0) {
+        return write_list(list, filename);
+    }
+    // drop items popped from the end
+    if (list->end < list->size) {
+        return write_list(list, filename);
+    }
+    // write the new items, they are all at the end of the list, and record where they start
+    int appended = list->appended;
+    long *offsets = NULL;
+    if (appended > 0) {
+        FILE *file = fopen(filename, "ab");
+        if (file == NULL) {
+            return -1;
+        }
+        library_stats.opens++;
+        // buffer all of the new items so they reach the file in one write
+        setvbuf(file, NULL, _IOFBF, items_size(list, list->count - appended, list->count) + 2);
+        // the last stored line needs its newline before anything can follow it
+        long offset = list->end;
+        if (list->open_end) {
+            fputc('\n', file);
+            offset++;
+        }
+        // without memory for the offsets the line index is dropped instead of updated
+        offsets = counted_malloc(sizeof(long) * appended);
+        offset = write_items(list, file, list->count - appended, list->count, offset, offsets);
+        library_stats.bytes_written += offset - list->end;
+        if (fclose(file) != 0) {
+            counted_free(offsets);
+            return -1;
+        }
+        list->size = offset;
+        list->end = offset;
+        list->open_end = 0;
+        list->appended = 0;
+    }
+    // keep the line index in step, items pushed into the gap shift every line so it is rebuilt instead
+    if (pushed > 0 || (appended > 0 && offsets == NULL)) {
+        index_drop(filename);
+    }
+    else if (appended > 0 || list->popped_front > 0 || list->popped_back > 0) {
+        index_update(filename, old_size, list->popped_front, list->popped_back, offsets, appended);
+    }
+    list->popped_front = 0;
+    list->popped_back = 0;
+    counted_free(offsets);
+    return 0;
+}
+
+// check if a list has changes that save_list has not written yet
+int unsaved(list_t *list) {
+    return list->dirty || list->pushed > 0 || list->appended > 0 || list->start != list->origin || list->end < list->size;
+}
+
+// find the offset of the first item of a front-offset list
+// returns 0 if the bytes do not start with a valid header
+long front_offset(char* bytes, long size) {
+    int magic = strlen(FRONT_MAGIC);
+    if (size < FRONT_HEADER || memcmp(bytes, FRONT_MAGIC, magic) != 0 || bytes[FRONT_HEADER - 1] != '\n') {
+        return 0;
+    }
+    long offset = 0;
+    for (int i = magic; i < FRONT_HEADER - 1; i++) {
+        if (!isdigit((unsigned char) bytes[i])) {
+            return 0;
+        }
+        offset = offset * 10 + (bytes[i] - '0');
+    }
+    // the offset has to land between the header and the end of the file
+    if (offset < FRONT_HEADER || offset > size) {
+        return 0;
+    }
+    return offset;
+}
+
+// find the offset of the string heap of a binary list
+// returns 0 if the bytes do not start with a valid header
+long binary_offset(char* bytes, long size, uint64_t *count) {
+    if (size < (long) sizeof(bin_header) || memcmp(bytes, BINARY_MAGIC, strlen(BINARY_MAGIC)) != 0) {
+        return 0;
+    }
+    bin_header header;
+    memcpy(&header, bytes, sizeof(bin_header));
+    // the header, the table and the heap have to make up the whole file
+    uint64_t table = (uint64_t) (size - sizeof(bin_header)) / sizeof(uint64_t);
+    if (header.count >= table || header.count >= INT_MAX) {
+        return 0;
+    }
+    long heap = sizeof(bin_header) + sizeof(uint64_t) * (header.count + 1);
+    if (header.heap != (uint64_t) (size - heap)) {
+        return 0;
+    }
+    *count = header.count;
+    return heap;
+}
+
+// open a front-offset list file and read where its items start and how big it is
+// returns null if the file does not open or is not a front-offset list
+static FILE* open_front(char* filename, long *start, long *size) {
+    FILE *file = fopen(filename, "r+b");
+    if (file == NULL) {
+        return NULL;
+    }
+    library_stats.opens++;
+    library_stats.bytes_read += FRONT_HEADER;
+    char header[FRONT_HEADER];
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fread(header, 1, FRONT_HEADER, file) != FRONT_HEADER) {
+        fclose(file);
+        return NULL;
+    }
+    *start = front_offset(header, *size);
+    if (*start == 0) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+// push a value onto a front-offset list file by writing it into the gap
+int front_push(char* filename, char* value) {
+    long start, size;
+    FILE *file = open_front(filename, &start, &size);
+    if (file == NULL) {
+        return 1;
+    }
+    // the value and its newline have to fit between the header and the first item
+    long len = strlen(value);
+    if (start - FRONT_HEADER < len + 1) {
+        fclose(file);
+        return 1;
+    }
+    start -= len + 1;
+    fseek(file, start, SEEK_SET);
+    fwrite(value, 1, len, file);
+    fputc('\n', file);
+    library_stats.bytes_written += len + 1 + FRONT_HEADER;
+    fseek(file, 0, SEEK_SET);
+    fprintf(file, "%s%020ld\n", FRONT_MAGIC, start);
+    if (fclose(file) != 0) {
+        return -1;
+    }
+    // every line moved down by one, the line index is rebuilt the next time it is needed
+    index_drop(filename);
+    return 0;
+}
+
+// pop a value from a front-offset list file by moving the header past it
+int front_pop(char* filename, char** value) {
+    long start, size;
+    FILE *file = open_front(filename, &start, &size);
+    if (file == NULL) {
+        return 1;
+    }
+    // if the list is empty, return 2
+    if (start >= size) {
+        fclose(file);
+        return 2;
+    }
+    // read the first item, it can be any length
+    long capacity = 256;
+    long len = 0;
+    char *item = counted_malloc(capacity);
+    if (item == NULL) {
+        fclose(file);
+        return -1;
+    }
+    fseek(file, start, SEEK_SET);
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n') {
+        if (len + 1 == capacity) {
+            char *grown = counted_realloc(item, capacity * 2);
+            if (grown == NULL) {
+                counted_free(item);
+                fclose(file);
+                return -1;
+            }
+            item = grown;
+            capacity *= 2;
+        }
+        item[len++] = c;
+    }
+    long next = start + len + (c == '\n');
+    library_stats.bytes_read += next - start;
+    // drop the carriage return of a CRLF line ending
+    if (len > 0 && item[len - 1] == '\r') {
+        len--;
+    }
+    item[len] = '\0';
+    // leave compaction to save_list once the gap outgrows the items
+    long gap = next - FRONT_HEADER;
+    if (gap > FRONT_COMPACT && gap > size - next) {
+        counted_free(item);
+        fclose(file);
+        return 1;
+    }
+    // only the header changes, the item is left in the gap for readers that read the old header
+    library_stats.bytes_written += FRONT_HEADER;
+    fseek(file, 0, SEEK_SET);
+    fprintf(file, "%s%020ld\n", FRONT_MAGIC, next);
+    if (fclose(file) != 0) {
+        counted_free(item);
+        return -1;
+    }
+    index_update(filename, size, 1, 0, NULL, 0);
+    *value = item;
+    return 0;
+}
+
+// remove a list item by index
+// if the index is out of bounds, return null
+// take in the list and the index
+// it is zero indexed
+char* rem_index(list_t *list, int index) {
+    // if the index is out of bounds, return NULL
+    if (index < 0 || index >= list->count) {
+        return NULL;
+    }
+    // otherwise, remove the item at the index
+    return remove_value(list, index);
+}
+
+// remove a list item by value
+// if the value is missing return null
+// take in the list and the value
+char* rem_value(list_t *list, char* value) {
+    // if the list is empty, return NULL
+    if (list->count == 0) {
+        return NULL;
+    }
+
+    // if there is a newline character at the end of the value, remove it
+    if (value[strlen(value) - 1] == '\n') {
+        value[strlen(value) - 1] = '\0';
+    }
+
+    // find the first item with the value
+    if (list->engine == ENGINE_ARRAY || list->lookup != NULL) {
+        int index = index_of(list, value);
+        return index < 0 ? NULL : remove_value(list, index);
+    }
+    for (node *current = list->head; current != NULL; current = current->next) {
+        if (strcmp(current->value, value) == 0) {
+            return unlink_node(list, current);
+        }
+    }
+    // if the value is not found, return NULL
+    return NULL;
+}
+
+// remove a set of values from the list in one pass
+// the values go into a table, then every item is checked against it, so k values cost one pass instead of k.
+// a value given n times removes its first n items, the same as calling rem_value for each value in turn.
+// found[i] is set to 1 if values[i] removed an item, the number of items removed is returned
+int rem_values(list_t *list, char** values, int n, int *found) {
+    hash_table *wanted = new_table(n);
+    if (wanted == NULL) {
+        memset(found, 0, sizeof(int) * n);
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        // if there is a newline character at the end of the value, remove it
+        size_t len = strlen(values[i]);
+        if (len > 0 && values[i][len - 1] == '\n') {
+            values[i][--len] = '\0';
+        }
+        // count and index of a value's slot are how many more items to remove and how many were removed
+        hash_slot *slot = table_add(wanted, values[i], len);
+        slot->count++;
+        slot->index = 0;
+        found[i] = 0;
+    }
+    int removed = 0;
+    if (list->engine == ENGINE_ARRAY) {
+        // keep the items that stay, sliding them down over the removed ones
+        int kept = 0;
+        long last = NEW_FRONT;
+        for (int i = 0; i < list->count; i++) {
+            item *slot = SLOT(list, i);
+            hash_slot *match = table_find(wanted, slot->value, slot->len);
+            if (match != NULL && match->count > 0) {
+                // the neighbours are the last item kept and the next item, as if the items were removed one by one
+                track_removal(list, slot->offset, last, i < list->count - 1 ? slot[1].offset : NEW_BACK);
+                match->count--;
+                match->index++;
+                removed++;
+                continue;
+            }
+            last = slot->offset;
+            *SLOT(list, kept++) = *slot;
+        }
+        list->count = kept;
+    }
+    else {
+        node *current = list->head;
+        while (current != NULL) {
+            node *next = current->next;
+            hash_slot *match = table_find(wanted, current->value, strlen(current->value));
+            if (match != NULL && match->count > 0) {
+                unlink_node(list, current);
+                match->count--;
+                match->index++;
+                removed++;
+            }
+            current = next;
+        }
+    }
+    // hand out the removals to the values in the order they were given
+    for (int i = 0; i < n; i++) {
+        hash_slot *match = table_find(wanted, values[i], strlen(values[i]));
+        if (match->index > 0) {
+            match->index--;
+            found[i] = 1;
+        }
+    }
+    free_table(wanted);
+    return removed;
+}
+
+// remove an item from the end of the list
+// it takes in the list
+// free the memory of the last node
+char* pop_end(list_t *list) {
+    // if the list is empty, return NULL
+    if (list->count == 0) {
+        return NULL;
+    }
+    // the tail pointer or the array means we never walk the list
+    return remove_value(list, list->count - 1);
+}
+
+// build the value lookup table of a list
+// a value that is in the list more than once keeps the index of its first item, like the scan in index_of
+// without memory for the table the searches go on scanning and it is tried again LOOKUP_AFTER searches later
+static void build_lookup(list_t *list) {
+    list->lookup = new_table(list->count);
+    if (list->lookup == NULL) {
+        list->lookups = 0;
+        return;
+    }
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = 0; i < list->count; i++) {
+            item *slot = SLOT(list, i);
+            hash_slot *found = table_add(list->lookup, slot->value, slot->len);
+            if (found->index < 0) {
+                found->index = i;
+            }
+        }
+        return;
+    }
+    int index = 0;
+    for (node *current = list->head; current != NULL; current = current->next) {
+        hash_slot *found = table_add(list->lookup, current->value, strlen(current->value));
+        if (found->index < 0) {
+            found->index = index;
+        }
+        index++;
+    }
+}
+
+// return the index of a value in the list
+// if it is not found, return -1
+// take in the list and the value
+int index_of(list_t *list, char* value) {
+    // a list that is searched again without changing in between, in a script or the server,
+    // gets a lookup table so every later search is a single probe
+    if (list->lookup == NULL && ++list->lookups >= LOOKUP_AFTER) {
+        build_lookup(list);
+    }
+    if (list->lookup != NULL) {
+        hash_slot *found = table_find(list->lookup, value, strlen(value));
+        return found != NULL ? found->index : -1;
+    }
+    // find the item with the value
+    // the array engine knows every length, so most items are ruled out without touching their bytes
+    if (list->engine == ENGINE_ARRAY) {
+        size_t len = strlen(value);
+        for (int i = 0; i < list->count; i++) {
+            item *slot = SLOT(list, i);
+            if (slot->len == len && memcmp(slot->value, value, len) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    int index = 0;
+    for (node *current = list->head; current != NULL; current = current->next) {
+        if (strcmp(current->value, value) == 0) {
+            return index;
+        }
+        index++;
+    }
+    // if the value is not found, return -1
+    return -1;
+}
+
+// get the value at an index, returns null if the index is out of bounds
+// the value belongs to the list
+char* get_value(list_t *list, int index) {
+    if (index < 0 || index >= list->count) {
+        return NULL;
+    }
+    return value_at(list, index);
+}
+
+// print the index specified to the screen
+// attach a newline character to the end of the value
+int print_index(list_t *list, int index) {
+    // if the list is empty, return
+    if (list->count == 0) {
+        return -1;
+    }
+
+    // if the index is out of bounds, return
+    if (index < 0) {
+        return -2;
+    }
+
+    // if the index is larger than the length of the list, return
+    if (index > list->count - 1) {
+        return -3;
+    }
+    // print the value of the item
+    printf("%s\n", value_at(list, index));
+    return 0 ;
+}
+
+// add an item and its newline to the print buffer, handing the buffer to the writer when it is full
+// returns the writer's result, 0 unless it failed
+static int print_item(char *block, size_t *used, char* value, size_t len, item_writer write, void *context) {
+    int result = 0;
+    if (*used + len + 1 > PRINT_BLOCK) {
+        result = write(context, block, *used);
+        *used = 0;
+    }
+    // an item bigger than the buffer goes out on its own
+    if (len + 1 > PRINT_BLOCK) {
+        if (result == 0) {
+            result = write(context, value, len);
+        }
+        if (result == 0) {
+            result = write(context, "\n", 1);
+        }
+        return result;
+    }
+    memcpy(block + *used, value, len);
+    *used += len;
+    block[(*used)++] = '\n';
+    return result;
+}
+
+// the writer print_range uses, the context is the stream
+static int write_stream(void *context, const char *bytes, size_t len) {
+    return fwrite(bytes, 1, len, (FILE *) context) == len ? 0 : -1;
+}
+
+// print the items from one index to another, both included, each followed by a newline
+// if the list is empty return -1, if from is negative return -2 and if from is past the last item or after to return -3
+// a to past the last item stops at the last item
+int print_range(list_t *list, int from, int to) {
+    return write_range(list, from, to, write_stream, stdout);
+}
+
+// hand the items from one index to another to a writer, each followed by a newline
+// the items are gathered into big blocks so a long list is a few writes instead of one per item
+// returns the codes of print_range, or -4 if the writer failed. nothing more is written once it has failed
+int write_range(list_t *list, int from, int to, item_writer write, void *context) {
+    // if the list is empty, return -1
+    if (list->count == 0) {
+        return -1;
+    }
+    // if from is negative, return -2
+    if (from < 0) {
+        return -2;
+    }
+    // if from is too big or the range is backwards, return -3
+    if (from >= list->count || from > to) {
+        return -3;
+    }
+    if (to >= list->count) {
+        to = list->count - 1;
+    }
+    char *block = counted_malloc(PRINT_BLOCK);
+    if (block == NULL) {
+        return -5;
+    }
+    size_t used = 0;
+    int result = 0;
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = from; i <= to && result == 0; i++) {
+            result = print_item(block, &used, SLOT(list, i)->value, SLOT(list, i)->len, write, context);
+        }
+    }
+    else {
+        // walk to the first item, then print until the last
+        node *current = list->head;
+        for (int i = 0; i < from; i++) {
+            current = current->next;
+        }
+        for (int i = from; i <= to && result == 0; i++) {
+            result = print_item(block, &used, current->value, strlen(current->value), write, context);
+            current = current->next;
+        }
+    }
+    if (result == 0 && used > 0) {
+        result = write(context, block, used);
+    }
+    counted_free(block);
+    return result == 0 ? 0 : -4;
+}
+
+// print the entire list
+// attach a newline character to the end of each value
+void print_list(list_t *list) {
+    // if the list is empty, say so
+    if (list->count == 0) {
+        printf("Empty list.\n");
+        return;
+    }
+    print_range(list, 0, list->count - 1);
+}
+
+
+
+// search for an item at the index and return the value length
+// if the list is empty return -1, if the index is out of bounds return -2
+// take in the list and the index
+// the length of the string does not include the newline character
+int value_length(list_t *list, int index) {
+    // if the list is empty, return -1
+    if (list->count == 0) {
+        return -1;
+    }
+    // if the index is out of bounds, return -2
+    if (index < 0 || index >= list->count) {
+        return -2;
+    }
+    // return the length of the value, the array engine already knows it
+    if (list->engine == ENGINE_ARRAY) {
+        return SLOT(list, index)->len;
+    }
+    return strlen(node_at(list, index)->value);
+}
+
+// insert a value at the specified index
+// the existing value at the index is pushed to the right
+// take in the list, the index, and the value
+// returns 0 on success, -2 if the index is negative and -3 if it is past the end of the list
+int insert_index(list_t *list, int index, char* value) {
+    // if the index is out of bounds, return -2
+    if (index < 0) {
+        return -2;
+    }
+    // if the index is 0, push the first item
+    if (index == 0) {
+        return push(list, value);
+    }
+
+    // if the index is larger than the length of the list, return -3
+    if (index > list->count) {
+        return -3;
+    }
+
+    // inserting after the last item is an append
+    if (index == list->count) {
+        return append(list, value);
+    }
+
+    // put the new item in front of the item at the index
+    // the stored items are no longer contiguous so the file has to be rewritten
+    if (insert_value(list, index, arena_strdup(list, value), NEW_BACK) != 0) {
+        return -1;
+    }
+    list->dirty = 1;
+    return 0;
+}
+
+// reverse a list in place by swapping every node's links, or swapping items from both ends of the array
+int reverse(list_t *list) {
+    // if the list is empty, return
+    if (list->count == 0) {
+        return -1;
+    }
+    list->dirty = 1;
+    forget_lookup(list);
+    if (list->engine == ENGINE_ARRAY) {
+        for (int i = 0, j = list->count - 1; i < j; i++, j--) {
+            item swap = *SLOT(list, i);
+            *SLOT(list, i) = *SLOT(list, j);
+            *SLOT(list, j) = swap;
+        }
+        return 0;
+    }
+    node *current = list->head;
+    while (current != NULL) {
+        node *next = current->next;
+        current->next = current->prev;
+        current->prev = next;
+        current = next;
+    }
+    // the old tail is the new head
+    node *old_head = list->head;
+    list->head = list->tail;
+    list->tail = old_head;
+    return 0;
+}
+
+// define a sort function, it takes in a list and a boolean for ascending or descending
+// every item is parsed once into a signed 64 bit number, the (number, item) pairs are radix sorted
+// and the items are written back in their new order with their text unchanged
+// if it encounters a non-integer it will return -1
+int sort(list_t *list, int ascending) {
+    // if the list is empty return -1
+    if (list->count == 0) {
+        return -1;
+    }
+
+    // if the list has only one item, it is already sorted
+    if (list->count == 1) {
+        return 0;
+    }
+
+    // parse and sort the values, return -1 if there is a non-integer and -2 if it ran out of memory
+    char **values = list_values(list);
+    if (values == NULL) {
+        return -2;
+    }
+    int sorted = number_sort(values, list->count, ascending);
+    if (sorted != 0) {
+        counted_free(values);
+        return sorted;
+    }
+    // write the items back into the list in their new order
+    set_values(list, values);
+    counted_free(values);
+    list->dirty = 1;
+    return 0;
+
+}
+
+// sort a list of strings in the order given, see listsort.c
+// returns -1 if the list is empty and -2 if it ran out of memory
+int sortlex(list_t *list, lex_order *order) {
+    // if the list is empty, return -1
+    if (list->count == 0) {
+        return -1;
+    }
+    // if the list has only one item, it is already sorted
+    if (list->count == 1) {
+        return 0;
+    }
+    char **values = list_values(list);
+    if (values == NULL) {
+        return -2;
+    }
+    if (lex_sort(values, list->count, order) != 0) {
+        counted_free(values);
+        return -2;
+    }
+    // write the values back into the list
+    set_values(list, values);
+    counted_free(values);
+    list->dirty = 1;
+    return 0;
+}
+
+int sortstring(list_t *list, int ascending) {
+    // a function that sorts the list based on the length of the strings, it supports alphanumeric characters.
+    // it takes in a list and a boolean for ascending or descending
+    // items of the same length keep their order
+    lex_order order;
+    order.modes[0] = LEX_LENGTH;
+    order.keys = 1;
+    order.ascending = ascending;
+    order.stable = 1;
+    return sortlex(list, &order);
+}
+
+//
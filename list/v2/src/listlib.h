@@ -1,67 +1,296 @@
-// header file for listlib.c
-
-#ifndef LISTLIB_H
-#define LISTLIB_H
-
-// the node structure
-typedef struct node {} node;
-
-// create a node
-node *create_node (char* value);
-
-// push a node to the front of the list.
-void push (node **head, char* value);
-
-// pop a node from the front of the list and return its value
-char* pop (node **head);
-
-// create a list from a file
-node* create_list (char* filename);
-
-// export a list
-void export_list (node* head, char* filename);
-
-// remove a list item by index
-// if the index is out of bounds, return null
-// take in the list head and the index
-// it is zero indexed
-char* rem_index (node **head, int index);
-
-// remove a list item by value
-// if the value is missing return null
-// take in the list head and the value
-char* rem_value (node **head, char* value);
-
-// append 
-void append (node **head, char* value);
-
-// pop end
-char* pop_end (node **head);
-
-// get the index of a value
-int index_of(node *head, char* value);
-
-// print a list item
-int print_index(node *head, int index);
-
-// print the entire list
-void print_list(node *head);
-
-// get the length of the list
-int length(node *head);
-
-// get the length of a value in the list
-int value_length(node *head, int index);
-
-void insert_index(node **head, int index, char* value);
-
-// reverse a list
-node* reverse(node *head);
-
-// sort a list, 0 ascending 1 descending
-node* sort(node *old_list, int ascending);
-
-// sort a list of strings
-node* sortstring(node* head, int ascending);
-
+// header file for listlib.c
+
+#ifndef LISTLIB_H
+#define LISTLIB_H
+
+#include "listhash.h"
+#include "listsort.h"
+#include "liststat.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// the node structure
+// nodes are doubly linked so the tail can be removed without walking the list
+// offset is where the item starts in the list file, or NEW_FRONT / NEW_BACK for items not written yet
+typedef struct node {
+    char* value;
+    struct node *next;
+    struct node *prev;
+    long offset;
+} node;
+
+#define NEW_FRONT -1
+#define NEW_BACK -2
+
+// an item of the array engine
+// the array engine keeps every item in one contiguous array, so index operations are O(1) and scans stay in cache.
+// value points into the file buffer or the arena and len is its length without the terminator
+typedef struct item {
+    char* value;
+    size_t len;
+    long offset;
+} item;
+
+// list engines
+// the linked engine keeps items in nodes, the array engine in one array of items with room at both ends.
+// new lists use LIST_ENGINE unless the LIST_ENGINE environment variable says "linked" or "array"
+#define ENGINE_LINKED 0
+#define ENGINE_ARRAY 1
+#ifndef LIST_ENGINE
+#define LIST_ENGINE ENGINE_LINKED
+#endif
+
+// list file formats
+// a plain list is one item per line
+// a front-offset list starts with a fixed size header line holding the offset of the first item,
+// the bytes between the header and the first item are a gap of empty lines that push writes into
+// and pop grows, so neither has to rewrite the file
+#define FORMAT_PLAIN 0
+#define FORMAT_FRONT 1
+#define FRONT_MAGIC "#LISTFRONT "
+#define FRONT_HEADER 32
+// the gap left in front of the items when a front-offset list is written out
+#define FRONT_GAP 4096
+// the file is compacted once the gap passes this size and outgrows the items
+#define FRONT_COMPACT (1024 * 1024)
+// a binary list (.lstb by convention) starts with a bin_header, then a table of count + 1 item offsets and then
+// the string heap, which holds every item followed by a newline. an offset counts from the start of the heap
+// and the last one is the size of the heap, so item i is the bytes from offsets[i] to offsets[i + 1] less its newline.
+// a mapped binary list finds any item and its length in one lookup and never scans the file.
+// the numbers are stored in the byte order of the machine that wrote the file, checksum is hash_value of the heap.
+// a binary list is rewritten whole when it changes
+#define FORMAT_BINARY 2
+#define BINARY_MAGIC "LISTBIN1"
+
+typedef struct bin_header {
+    char magic[8];
+    uint64_t count;
+    uint64_t heap;
+    uint64_t checksum;
+} bin_header;
+// a block list (.lstz by convention) keeps its items in blocks that are compressed one by one, see listblk.h.
+// it is loaded as the text of its items and written back through a block writer, item offsets count in that text
+#define FORMAT_BLOCKS 3
+
+// a block of memory that a list carves its nodes and strings out of
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    char data[];
+} arena_block;
+
+// the first arena block of a list, later blocks double in size up to the maximum
+#define ARENA_BLOCK (16 * 1024)
+#define ARENA_BLOCK_MAX (4 * 1024 * 1024)
+
+// index_of builds a value lookup table on this call, the first search is a scan since a table costs more than one scan
+#define LOOKUP_AFTER 2
+
+// the list handle
+// keeps the head, the tail and the number of items current so append, pop_end and length are O(1)
+// buffer holds the file contents loaded by create_list, values loaded from the file point into it
+// nodes and new values come from the arena, unlinked nodes wait in spare to be reused
+// with the array engine head and tail stay null, the items are items[first] to items[first + count - 1]
+// the remaining fields track how the list differs from the file so save_list only writes the change:
+// the items still stored in the file are the bytes from start to end, pushed and appended count the
+// new items at either end and dirty is set once the stored items change order or lose a middle item
+// origin is where the stored items began when the file was last read or written
+// popped_front and popped_back count the stored items removed from either end, to keep the line index in step
+// lookup maps each value to the index of its first item, it is built once index_of has been called LOOKUP_AFTER
+// times without the list changing in between and dropped whenever the list changes, lookups counts the calls
+typedef struct list_t {
+    node *head;
+    node *tail;
+    int count;
+    char *buffer;
+    arena_block *arena;
+    node *spare;
+    int engine;
+    item *items;
+    int first;
+    int capacity;
+    int format;
+    long size;
+    long origin;
+    long start;
+    long end;
+    int open_end;
+    int pushed;
+    int appended;
+    int popped_front;
+    int popped_back;
+    int dirty;
+    hash_table *lookup;
+    int lookups;
+} list_t;
+
+// create an empty list with the default engine, returns null if it ran out of memory
+list_t* new_list (void);
+
+// create an empty list with a specific engine, returns null if it ran out of memory
+list_t* new_list_engine (int engine);
+
+// free a list and everything it owns, including values returned by pop and the other removal functions
+void free_list (list_t *list);
+
+// create a node, the value is copied into the list's arena. returns null if it ran out of memory
+node *create_node (list_t *list, char* value);
+
+// push a node to the front of the list.
+// returns 0 on success and -1 if it ran out of memory, the list is then left as it was
+int push (list_t *list, char* value);
+
+// pop a node from the front of the list and return its value
+char* pop (list_t *list);
+
+// create a list from a file
+// returns null if the file does not open, is a damaged binary or block list or does not fit in memory
+list_t* create_list (char* filename);
+
+// export a list, returns 0 on success and -1 if the file could not be written
+int export_list (list_t *list, char* filename);
+
+// start a list file in a format, returns the offset where the first item goes
+long write_header (FILE *file, int format);
+
+// put a finished file in place of another in one step, returns 0 on success and -1 on error
+int replace_file (char* from, char* to);
+
+// the file a list file's name stands for, with every symbolic link followed
+// rewrites are renamed over that file and its writer lock is next to it, so a link to a list stays a link and
+// the list has one lock whichever name it is reached by. a name that does not resolve, such as a list that is
+// not there yet, comes back as it is. returns a copy to free with counted_free, or null if it ran out of memory
+char* resolve_list (char* filename);
+
+// give a file that is about to replace a list file the permissions, owner and group of the list file
+// an owner that cannot be set, as anyone but root, is left at the user writing the file
+void keep_mode (FILE *file, char* filename);
+
+// the writer lock of a list file
+// every command that changes a list file holds an exclusive lock on <listfile>.lock from before it reads the
+// list until its changes are written, so writers take turns and none of them loses another one's change.
+// readers take no lock, writers publish rewrites by renaming a finished file over the list.
+// the lock is on a file of its own since a rewritten list file is a new file and a lock on the old one
+// would not stop the next writer
+#define LOCK_SUFFIX ".lock"
+
+typedef struct list_lock {
+#ifdef _WIN32
+    void *handle;
+#else
+    int fd;
+#endif
+} list_lock;
+
+// take the writer lock of a list file, waiting until no other writer holds it
+// returns 0 on success and -1 if the lock file could not be opened or locked
+int lock_list (char* filename, list_lock *lock);
+
+// release the writer lock of a list file
+void unlock_list (list_lock *lock);
+
+// write the changes made to a list back to its file
+// appends only write the new items, pops from the end rewrite the file through write_list like any other
+// change to the stored items, since truncating it would crash a reader that has it mapped
+// returns 0 on success and -1 if the file could not be written
+int save_list (list_t *list, char* filename);
+
+// check if a list has changes that save_list has not written yet
+int unsaved (list_t *list);
+
+// find the offset of the first item of a front-offset list from the start of its file
+// returns 0 if the bytes are not a front-offset list
+long front_offset (char* bytes, long size);
+
+// find the offset of the string heap of a binary list from the start of its file and the number of items it holds
+// only the header is read, it has to account for exactly size bytes. returns 0 if the bytes are not a binary list
+long binary_offset (char* bytes, long size, uint64_t *count);
+
+// push a value onto a front-offset list file without loading the list
+// returns 0 on success, 1 if the file is not a front-offset list or the gap is too small and -1 on error
+int front_push (char* filename, char* value);
+
+// pop a value from a front-offset list file without loading the list
+// returns 0 on success, 1 if the file is not a front-offset list or is due for compaction,
+// 2 if the list is empty and -1 on error
+int front_pop (char* filename, char** value);
+
+// remove a list item by index
+// if the index is out of bounds, return null
+// take in the list and the index
+// it is zero indexed
+char* rem_index (list_t *list, int index);
+
+// remove a list item by value
+// if the value is missing return null
+// take in the list and the value
+char* rem_value (list_t *list, char* value);
+
+// remove a set of values in one pass over the list, a value given n times removes its first n items
+// found[i] is set to 1 if values[i] removed an item, returns the number of items removed
+// or -1 if it ran out of memory, nothing is removed then
+int rem_values (list_t *list, char** values, int n, int *found);
+
+// append
+// returns 0 on success and -1 if it ran out of memory, the list is then left as it was
+int append (list_t *list, char* value);
+
+// pop end
+char* pop_end (list_t *list);
+
+// get the index of a value
+int index_of(list_t *list, char* value);
+
+// get the value at an index, returns null if the index is out of bounds
+char* get_value(list_t *list, int index);
+
+// print a list item
+int print_index(list_t *list, int index);
+
+// print the entire list, every item followed by a newline
+void print_list(list_t *list);
+
+// print the items from one index to another, both included, every item followed by a newline
+// returns -1 if the list is empty, -2 if from is negative and -3 if from is too big or after to
+int print_range(list_t *list, int from, int to);
+
+// where write_range sends the items, it is given runs of bytes to write and returns 0 on success
+typedef int (*item_writer)(void *context, const char *bytes, size_t len);
+
+// hand the items from one index to another to a writer like print_range prints them
+// returns the codes of print_range, -4 if the writer failed or -5 if there was no memory for the print buffer
+int write_range(list_t *list, int from, int to, item_writer write, void *context);
+
+// get the length of the list
+int length(list_t *list);
+
+// the heap memory a list holds in bytes: its handle, the file buffer, the arena, the item array and the lookup table
+size_t list_memory(list_t *list);
+
+// get the length of a value in the list
+int value_length(list_t *list, int index);
+
+// insert a value at an index, the item at the index and those after it move one place down
+// returns 0 on success, -1 if it ran out of memory, -2 if the index is negative and -3 if it is past the end of the list
+int insert_index(list_t *list, int index, char* value);
+
+// reverse a list, returns -1 if the list is empty
+int reverse(list_t *list);
+
+// sort a list of signed 64 bit integers, ascending if ascending is set and descending if not
+// the items keep their text, so leading zeros and spaces survive
+// returns -1 if the list is empty or holds a non-integer and -2 if it ran out of memory
+int sort(list_t *list, int ascending);
+
+// sort a list of strings by length, ascending if ascending is set and descending if not
+// items of the same length keep their order
+// returns -1 if the list is empty and -2 if it ran out of memory
+int sortstring(list_t *list, int ascending);
+
+// sort a list of strings by one or more keys, see lex_order
+// returns -1 if the list is empty and -2 if it ran out of memory
+int sortlex(list_t *list, lex_order *order);
+
 #endif
\ No newline at end of file
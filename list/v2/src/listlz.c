@@ -0,0 +1,150 @@
+// compression library
+// a small LZ77 compressor that writes the LZ4 block format, used for the blocks of block lists.
+// lists of paths and host names repeat a lot within a few kilobytes, which is what it finds:
+// each 4 byte sequence is looked up in a table of where it was last seen and a match is stretched as far as it goes
+
+#include "listlz.h"
+#include <stdint.h>
+#include <string.h>
+
+// read 4 bytes without caring how they are aligned
+static uint32_t read32(unsigned char *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+// write the rest of a length that did not fit its 4 bits of the token
+static unsigned char* put_length(unsigned char *out, size_t len) {
+    while (len >= 255) {
+        *out++ = 255;
+        len -= 255;
+    }
+    *out++ = (unsigned char) len;
+    return out;
+}
+
+// write a sequence, the literals and then a match of len bytes offset bytes back. a len of 0 ends the data
+static unsigned char* put_sequence(unsigned char *out, unsigned char *literals, size_t count, size_t offset, size_t len) {
+    size_t match = len > 0 ? len - LZ_MIN_MATCH : 0;
+    *out++ = (unsigned char) (((count >= 15 ? 15 : count) << 4) | (match >= 15 ? 15 : match));
+    if (count >= 15) {
+        out = put_length(out, count - 15);
+    }
+    memcpy(out, literals, count);
+    out += count;
+    if (len == 0) {
+        return out;
+    }
+    *out++ = (unsigned char) (offset & 255);
+    *out++ = (unsigned char) (offset >> 8);
+    if (match >= 15) {
+        out = put_length(out, match - 15);
+    }
+    return out;
+}
+
+size_t lz_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+size_t lz_compress(char* src, size_t len, char* dst) {
+    unsigned char *in = (unsigned char *) src;
+    unsigned char *out = (unsigned char *) dst;
+    // where each sequence was last seen, an entry that was never set points at the start and fails the compare
+    uint32_t seen[1 << LZ_HASH_BITS];
+    memset(seen, 0, sizeof(seen));
+    size_t pos = 0;
+    size_t anchor = 0;
+    if (len > LZ_MATCH_LIMIT) {
+        size_t limit = len - LZ_MATCH_LIMIT;
+        while (pos < limit) {
+            uint32_t sequence = read32(in + pos);
+            uint32_t slot = (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+            size_t ref = seen[slot];
+            seen[slot] = (uint32_t) pos;
+            if (ref >= pos || pos - ref > LZ_MAX_OFFSET || read32(in + ref) != sequence) {
+                pos++;
+                continue;
+            }
+            // stretch the match, it has to stop before the last literals
+            size_t match = LZ_MIN_MATCH;
+            while (pos + match < len - LZ_LAST_LITERALS && in[ref + match] == in[pos + match]) {
+                match++;
+            }
+            out = put_sequence(out, in + anchor, pos - anchor, pos - ref, match);
+            pos += match;
+            anchor = pos;
+        }
+    }
+    // everything after the last match goes out as literals
+    out = put_sequence(out, in + anchor, len - anchor, 0, 0);
+    return out - (unsigned char *) dst;
+}
+
+int lz_decompress(char* src, size_t packed, char* dst, size_t size) {
+    unsigned char *in = (unsigned char *) src;
+    unsigned char *out = (unsigned char *) dst;
+    size_t pos = 0;
+    size_t done = 0;
+    while (pos < packed) {
+        unsigned char token = in[pos++];
+        // the literals, every length is checked against both buffers so damaged data cannot overrun them
+        size_t count = token >> 4;
+        if (count == 15) {
+            unsigned char more;
+            do {
+                if (pos >= packed) {
+                    return -1;
+                }
+                more = in[pos++];
+                count += more;
+            } while (more == 255);
+        }
+        if (count > packed - pos || count > size - done) {
+            return -1;
+        }
+        memcpy(out + done, in + pos, count);
+        pos += count;
+        done += count;
+        // the last sequence has no match
+        if (pos == packed) {
+            break;
+        }
+        if (packed - pos < 2) {
+            return -1;
+        }
+        size_t offset = in[pos] | (in[pos + 1] << 8);
+        pos += 2;
+        if (offset == 0 || offset > done) {
+            return -1;
+        }
+        size_t match = token & 15;
+        if (match == 15) {
+            unsigned char more;
+            do {
+                if (pos >= packed) {
+                    return -1;
+                }
+                more = in[pos++];
+                match += more;
+            } while (more == 255);
+        }
+        match += LZ_MIN_MATCH;
+        if (match > size - done) {
+            return -1;
+        }
+        // a match can overlap the bytes it is copying, a run of one byte is a match one byte back
+        unsigned char *from = out + done - offset;
+        if (offset >= match) {
+            memcpy(out + done, from, match);
+        }
+        else {
+            for (size_t i = 0; i < match; i++) {
+                out[done + i] = from[i];
+            }
+        }
+        done += match;
+    }
+    return done == size ? 0 : -1;
+}
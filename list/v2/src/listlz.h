@@ -0,0 +1,30 @@
+// header file for listlz.c
+
+#ifndef LISTLZ_H
+#define LISTLZ_H
+
+#include <stddef.h>
+
+// the compressed data is a run of sequences in the LZ4 block format: a token holding the literal and match
+// lengths, the literals, a 2 byte offset back to the match and the rest of the lengths in 255 steps.
+// the last sequence is only literals, a match never starts in the last LZ_MATCH_LIMIT bytes
+// or ends in the last LZ_LAST_LITERALS
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_LIMIT 12
+#define LZ_MAX_OFFSET 65535
+// the compressor remembers where it last saw 1 << LZ_HASH_BITS different 4 byte sequences
+#define LZ_HASH_BITS 14
+
+// the most bytes compressing len bytes can take
+size_t lz_bound (size_t len);
+
+// compress len bytes of src into dst, which has room for lz_bound(len) bytes
+// returns the size of the compressed data
+size_t lz_compress (char* src, size_t len, char* dst);
+
+// decompress packed bytes of src into dst, which has room for exactly size bytes
+// returns 0 on success and -1 if the data is damaged or does not come out at size bytes
+int lz_decompress (char* src, size_t packed, char* dst, size_t size);
+
+#endif
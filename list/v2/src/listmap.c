@@ -0,0 +1,391 @@
+// mapped list library
+// answers read-only questions straight from the bytes of a list file
+// nothing is allocated and no item is copied, an item is a pointer into the mapping plus a length
+// items follow the same rules as create_list: one per line, the newline and a CRLF carriage return are not part of the item
+
+#include "listmap.h"
+#include "listlib.h"
+#include "listscan.h"
+#include "listidx.h"
+#include "listblk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+// map a list file read-only
+// an empty file has nothing to map, it is reported as an empty list
+int map_list(char* filename, list_map *map) {
+    memset(map, 0, sizeof(list_map));
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return -1;
+    }
+    map->file = file;
+    if (size.QuadPart == 0) {
+        return 0;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return -1;
+    }
+    void *base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (base == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return -1;
+    }
+    map->mapping = mapping;
+    map->length = (size_t) size.QuadPart;
+#else
+    map->fd = -1;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    // only regular files can be mapped, anything else goes through the normal loader
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return -1;
+    }
+    // an empty file keeps its descriptor too, the sidecars describe the file through it
+    map->fd = fd;
+    if (st.st_size == 0) {
+        library_stats.opens++;
+        return 0;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        map->fd = -1;
+        return -1;
+    }
+    // the file stays open so print can send it to stdout without copying it through the mapping
+    map->length = st.st_size;
+#endif
+    library_stats.opens++;
+    library_stats.maps++;
+    library_stats.bytes_mapped += map->length;
+    map->base = base;
+    map->data = base;
+    map->size = map->length;
+    // the items of a block list are compressed, it is read through listblk instead
+    if (block_magic(base, map->length)) {
+        unmap_list(map);
+        return -1;
+    }
+    // a front-offset list keeps its items after the header and the gap
+    long origin = front_offset(base, map->length);
+    // a binary list keeps them after its offset table
+    uint64_t count;
+    long heap = binary_offset(base, map->length, &count);
+    if (heap > 0) {
+        origin = heap;
+        map->offsets = (uint64_t *) ((char *) base + sizeof(bin_header));
+        map->count = count;
+    }
+    map->data += origin;
+    map->size -= origin;
+    return 0;
+}
+
+// release a mapped list file
+void unmap_list(list_map *map) {
+#ifdef _WIN32
+    if (map->base != NULL) {
+        UnmapViewOfFile(map->base);
+        CloseHandle(map->mapping);
+    }
+    if (map->file != NULL) {
+        CloseHandle(map->file);
+    }
+#else
+    if (map->base != NULL) {
+        munmap(map->base, map->length);
+    }
+    if (map->fd >= 0) {
+        close(map->fd);
+    }
+#endif
+    memset(map, 0, sizeof(list_map));
+#ifndef _WIN32
+    map->fd = -1;
+#endif
+}
+
+// read the item that starts at pos
+// returns where the next item starts, or null once there are no items left
+static char* next_item(list_map *map, char *pos, char **item, size_t *len) {
+    char *end = map->data + map->size;
+    if (pos >= end) {
+        return NULL;
+    }
+    char *newline = find_newline(pos, end - pos);
+    char *stop = newline != NULL ? newline : end;
+    *item = pos;
+    *len = stop - pos;
+    // drop the carriage return of a CRLF line ending
+    if (*len > 0 && pos[*len - 1] == '\r') {
+        (*len)--;
+    }
+    return newline != NULL ? newline + 1 : end;
+}
+
+// count the items in a mapped list
+// every newline ends an item, and so does the end of the file
+int map_length(list_map *map) {
+    if (map->offsets != NULL) {
+        return (int) map->count;
+    }
+    return (int) count_lines(map->data, map->size);
+}
+
+// find the item at an index
+// returns 0 on success, -1 if the list is empty, -2 if the index is negative and -3 if it is too big
+int map_item(list_map *map, int index, char **item, size_t *len) {
+    return map_item_within(map, index, map->size, item, len);
+}
+
+// find the item at an index among the items that start in the first window bytes of the list
+// the walk stops at the item, so its cost depends on where the item is and not on the size of the list
+int map_item_within(list_map *map, int index, size_t window, char **item, size_t *len) {
+    // if the list is empty, return -1
+    if (map->size == 0) {
+        return -1;
+    }
+    // if the index is negative, return -2
+    if (index < 0) {
+        return -2;
+    }
+    // a binary list looks the item up in its offset table, an entry that does not fit the heap is walked to instead
+    if (map->offsets != NULL) {
+        if ((uint64_t) index >= map->count) {
+            return -3;
+        }
+        uint64_t from = map->offsets[index];
+        uint64_t to = map->offsets[index + 1];
+        if (from < to && to <= map->size) {
+            *item = map->data + from;
+            *len = to - from - 1;
+            return 0;
+        }
+    }
+    // walk the lines until we reach the index, stop early if we run out
+    char *pos = map->data;
+    for (int i = 0; i <= index; i++) {
+        if ((size_t) (pos - map->data) > window) {
+            return -4;
+        }
+        pos = next_item(map, pos, item, len);
+        if (pos == NULL) {
+            return -3;
+        }
+    }
+    return 0;
+}
+
+// get the index of a value
+// if it is not found, return -1
+int map_index_of(list_map *map, char* value) {
+    return map_index_within(map, value, map->size);
+}
+
+// get the index of a value among the items that start in the first window bytes of the list
+// the scan stops at the first match
+int map_index_within(list_map *map, char* value, size_t window) {
+    size_t value_len = strlen(value);
+    char *item;
+    size_t len;
+    int index = 0;
+    char *pos = map->data;
+    while ((pos = next_item(map, pos, &item, &len)) != NULL) {
+        if (len == value_len && memcmp(item, value, len) == 0) {
+            return index;
+        }
+        index++;
+        if ((size_t) (pos - map->data) > window) {
+            return -4;
+        }
+    }
+    // if the value is not found, return -1
+    return -1;
+}
+
+// send a run of bytes of the mapped file to stdout
+// on linux the kernel copies them from the file with sendfile, anything it does not take
+// is written from the mapping in big blocks
+static void send_bytes(list_map *map, char *start, size_t len) {
+    fflush(stdout);
+#if defined(__linux__)
+    off_t offset = start - (char *) map->base;
+    while (len > 0) {
+        ssize_t sent = sendfile(STDOUT_FILENO, map->fd, &offset, len);
+        if (sent <= 0) {
+            break;
+        }
+        start += sent;
+        len -= sent;
+    }
+#endif
+    while (len > 0) {
+        size_t block = len < PRINT_BLOCK ? len : PRINT_BLOCK;
+        if (fwrite(start, 1, block, stdout) != block) {
+            return;
+        }
+        start += block;
+        len -= block;
+    }
+}
+
+// print the items that lie between two positions in the mapped list, each followed by a newline
+void map_write(list_map *map, char *start, char *end) {
+    if (start >= end) {
+        return;
+    }
+    // items are printed without the carriage return of a CRLF line ending, so only bytes without one
+    // can go out as they are
+    if (memchr(start, '\r', end - start) == NULL) {
+        send_bytes(map, start, end - start);
+        // the last line of the file may not have a newline
+        if (end[-1] != '\n') {
+            putchar('\n');
+        }
+        return;
+    }
+    // gather the items into big blocks, leaving out the carriage returns
+    // without memory for a block every item goes out on its own
+    char *block = counted_malloc(PRINT_BLOCK);
+    size_t used = 0;
+    char *item;
+    size_t len;
+    char *pos = start;
+    list_map range = *map;
+    range.data = start;
+    range.size = end - start;
+    while ((pos = next_item(&range, pos, &item, &len)) != NULL) {
+        if (used > 0 && used + len + 1 > PRINT_BLOCK) {
+            fwrite(block, 1, used, stdout);
+            used = 0;
+        }
+        // an item bigger than the block goes out on its own
+        if (block == NULL || len + 1 > PRINT_BLOCK) {
+            fwrite(item, 1, len, stdout);
+            putchar('\n');
+            continue;
+        }
+        memcpy(block + used, item, len);
+        used += len;
+        block[used++] = '\n';
+    }
+    if (used > 0) {
+        fwrite(block, 1, used, stdout);
+    }
+    counted_free(block);
+}
+
+// print the entire mapped list
+// every item is followed by a newline, like print_list
+void map_print(list_map *map) {
+    // if the list is empty, say so
+    if (map->size == 0) {
+        printf("Empty list.\n");
+        return;
+    }
+    map_write(map, map->data, map->data + map->size);
+}
+
+// reverse a list file without loading it
+// the lines are read from the back of the mapped file and written in that order to a temporary file,
+// which then replaces the list, so only a buffer of the list is ever in memory.
+// the new file has the same layout write_list gives a reversed list: a fresh header and gap for a
+// front-offset list, and every item followed by a newline
+// returns 0 on success, 1 if the list is empty or the file could not be mapped and -1 on error
+int map_reverse(char* filename) {
+    list_map map;
+    if (map_list(filename, &map) != 0) {
+        return 1;
+    }
+    // a binary list has to be loaded to write its offset table
+    if (map.size == 0 || map.offsets != NULL) {
+        unmap_list(&map);
+        return 1;
+    }
+    // like write_list, a symbolic link is followed and the new file keeps the mode of the one it replaces
+    char *target = resolve_list(filename);
+    char *temp = target != NULL ? counted_malloc(strlen(target) + 5) : NULL;
+    if (temp == NULL) {
+        unmap_list(&map);
+        counted_free(target);
+        return -1;
+    }
+    strcpy(temp, target);
+    strcat(temp, ".tmp");
+    FILE *file = fopen(temp, "wb");
+    if (file == NULL) {
+        unmap_list(&map);
+        counted_free(temp);
+        counted_free(target);
+        return -1;
+    }
+    keep_mode(file, target);
+    setvbuf(file, NULL, _IOFBF, 1024 * 1024);
+    write_header(file, map.data != (char *) map.base ? FORMAT_FRONT : FORMAT_PLAIN);
+    // the newline after the last item ends it, it does not start another one
+    char *stop = map.data + map.size;
+    if (stop[-1] == '\n') {
+        stop--;
+    }
+    for (;;) {
+        char *newline = find_last_newline(map.data, stop - map.data);
+        char *item = newline != NULL ? newline + 1 : map.data;
+        size_t len = stop - item;
+        // drop the carriage return of a CRLF line ending
+        if (len > 0 && item[len - 1] == '\r') {
+            len--;
+        }
+        fwrite(item, 1, len, file);
+        fputc('\n', file);
+        if (newline == NULL) {
+            break;
+        }
+        stop = newline;
+    }
+    library_stats.opens++;
+    library_stats.bytes_written += ftell(file);
+    int failed = ferror(file) != 0;
+    if (fclose(file) != 0) {
+        failed = 1;
+    }
+    // the mapping has to be gone before the file can be replaced on windows
+    unmap_list(&map);
+    failed = failed || replace_file(temp, target) != 0;
+    counted_free(target);
+    if (failed) {
+        remove(temp);
+        counted_free(temp);
+        return -1;
+    }
+    counted_free(temp);
+    // every line moved, the sidecars are rebuilt the next time they are needed
+    index_drop(filename);
+    return 0;
+}
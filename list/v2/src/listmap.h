@@ -0,0 +1,63 @@
+// header file for listmap.c
+
+#ifndef LISTMAP_H
+#define LISTMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// a list file mapped read-only into memory
+// data and size cover the list items, the remaining fields belong to the platform mapping.
+// a binary list also has the offsets of its count items, data is then its string heap
+typedef struct list_map {
+    char *data;
+    size_t size;
+    uint64_t *offsets;
+    uint64_t count;
+    void *base;
+    size_t length;
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#else
+    int fd;
+#endif
+} list_map;
+
+// output is written in blocks of this size when it cannot be sent straight from the file
+#define PRINT_BLOCK (1024 * 1024)
+
+// map a list file, returns 0 on success and -1 if the file could not be mapped or is a block list
+int map_list (char* filename, list_map *map);
+
+// release a mapped list file
+void unmap_list (list_map *map);
+
+// count the items in a mapped list
+int map_length (list_map *map);
+
+// find the item at an index, the item is not terminated so its length is returned through len
+// returns 0 on success, -1 if the list is empty, -2 if the index is negative and -3 if it is too big
+int map_item (list_map *map, int index, char **item, size_t *len);
+
+// find the item at an index like map_item, but give up with -4 once the walk passes the first window bytes of the list
+int map_item_within (list_map *map, int index, size_t window, char **item, size_t *len);
+
+// get the index of a value, returns -1 if it is not found
+int map_index_of (list_map *map, char* value);
+
+// get the index of a value like map_index_of, but give up with -4 once the scan passes the first window bytes of the list
+int map_index_within (list_map *map, char* value, size_t window);
+
+// print the entire mapped list, in the same layout as print_list
+void map_print (list_map *map);
+
+// print the items that lie between two positions in the mapped list, each followed by a newline
+// a run of bytes without carriage returns is sent straight from the file to stdout
+void map_write (list_map *map, char *start, char *end);
+
+// reverse a list file by streaming it backwards into a new file, without loading the list
+// returns 0 on success, 1 if the list is empty, is a binary list or the file could not be mapped and -1 on error
+int map_reverse (char* filename);
+
+#endif
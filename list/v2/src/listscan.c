@@ -0,0 +1,248 @@
+// newline scanning library
+// every command that reads a list file looks for newlines, so finding and counting them is done
+// 16 or 32 bytes at a time with SSE2 or AVX2 where the compiler and the processor have them.
+// the kernel is picked the first time it is needed, other compilers and processors use the
+// portable version, which works on 8 bytes at a time
+
+#include "listscan.h"
+#include <stdint.h>
+#include <string.h>
+
+// the vector kernels need GCC or Clang on x86, TinyCC and everything else get the portable version
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__TINYC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_VECTOR 1
+#include <immintrin.h>
+#endif
+
+// portable versions
+
+// count the newlines a word at a time
+// a byte of the word is 0 exactly where the bytes held a newline, every such byte sets its top bit in found
+static size_t count_newlines_word(char* bytes, size_t len) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t low = 0x7f7f7f7f7f7f7f7fULL;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        word ^= ones * '\n';
+        uint64_t found = ~(((word & low) + low) | word | low);
+        // add up the top bits, one per newline
+        count += ((found >> 7) * ones) >> 56;
+    }
+    for (; i < len; i++) {
+        count += bytes[i] == '\n';
+    }
+    return count;
+}
+
+// the C library's memchr is already vectorised on most platforms
+static char* find_newline_libc(char* bytes, size_t len) {
+    return memchr(bytes, '\n', len);
+}
+
+// look for the last newline a byte at a time
+static char* find_last_newline_byte(char* bytes, size_t len) {
+    while (len > 0) {
+        len--;
+        if (bytes[len] == '\n') {
+            return bytes + len;
+        }
+    }
+    return NULL;
+}
+
+#ifdef SCAN_VECTOR
+
+// SSE2 versions, every x86-64 processor has SSE2
+
+__attribute__((target("sse2")))
+static size_t count_newlines_sse2(char* bytes, size_t len) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 16 <= len) {
+        // a compare gives -1 for every newline, subtracting it counts the newlines in bytes,
+        // which are added up before any of them can pass 255
+        __m128i counts = zero;
+        size_t stop = len - i < 255 * 16 ? i + (len - i) / 16 * 16 : i + 255 * 16;
+        for (; i < stop; i += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i *) (bytes + i));
+            counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(chunk, newline));
+        }
+        __m128i sums = _mm_sad_epu8(counts, zero);
+        count += (size_t) _mm_cvtsi128_si32(sums) + (size_t) _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+    return count + count_newlines_word(bytes + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static char* find_newline_sse2(char* bytes, size_t len) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (bytes + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return bytes + i + __builtin_ctz(mask);
+        }
+    }
+    return memchr(bytes + i, '\n', len - i);
+}
+
+__attribute__((target("sse2")))
+static char* find_last_newline_sse2(char* bytes, size_t len) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (len >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (bytes + len - 16));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return bytes + len - 16 + (31 - __builtin_clz(mask));
+        }
+        len -= 16;
+    }
+    return find_last_newline_byte(bytes, len);
+}
+
+// AVX2 versions, for processors that have it
+
+__attribute__((target("avx2")))
+static size_t count_newlines_avx2(char* bytes, size_t len) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 32 <= len) {
+        __m256i counts = zero;
+        size_t stop = len - i < 255 * 32 ? i + (len - i) / 32 * 32 : i + 255 * 32;
+        for (; i < stop; i += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i *) (bytes + i));
+            counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(chunk, newline));
+        }
+        uint64_t sums[4];
+        _mm256_storeu_si256((__m256i *) sums, _mm256_sad_epu8(counts, zero));
+        count += (size_t) (sums[0] + sums[1] + sums[2] + sums[3]);
+    }
+    return count + count_newlines_word(bytes + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static char* find_newline_avx2(char* bytes, size_t len) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *) (bytes + i));
+        unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return bytes + i + __builtin_ctz(mask);
+        }
+    }
+    return find_newline_sse2(bytes + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static char* find_last_newline_avx2(char* bytes, size_t len) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (len >= 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *) (bytes + len - 32));
+        unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+        if (mask != 0) {
+            return bytes + len - 32 + (31 - __builtin_clz(mask));
+        }
+        len -= 32;
+    }
+    return find_last_newline_sse2(bytes, len);
+}
+
+#endif
+
+#ifdef SCAN_VECTOR
+
+// the kernels in use, picked on the first call
+// they are loaded and stored atomically, so threads scanning at the same time can all pick them,
+// every one of them stores the same kernels
+static size_t (*count_kernel)(char*, size_t) = NULL;
+static char* (*find_kernel)(char*, size_t) = NULL;
+static char* (*find_last_kernel)(char*, size_t) = NULL;
+
+// pick the fastest kernels this processor can run
+static void pick_kernels(void) {
+    size_t (*count)(char*, size_t) = count_newlines_word;
+    char* (*find)(char*, size_t) = find_newline_libc;
+    char* (*find_last)(char*, size_t) = find_last_newline_byte;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        count = count_newlines_avx2;
+        find = find_newline_avx2;
+        find_last = find_last_newline_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        count = count_newlines_sse2;
+        find = find_newline_sse2;
+        find_last = find_last_newline_sse2;
+    }
+    __atomic_store_n(&count_kernel, count, __ATOMIC_RELAXED);
+    __atomic_store_n(&find_kernel, find, __ATOMIC_RELAXED);
+    __atomic_store_n(&find_last_kernel, find_last, __ATOMIC_RELAXED);
+}
+
+// find the first newline in a run of bytes
+char* find_newline(char* bytes, size_t len) {
+    char* (*kernel)(char*, size_t) = __atomic_load_n(&find_kernel, __ATOMIC_RELAXED);
+    if (kernel == NULL) {
+        pick_kernels();
+        kernel = __atomic_load_n(&find_kernel, __ATOMIC_RELAXED);
+    }
+    return kernel(bytes, len);
+}
+
+// find the last newline in a run of bytes
+char* find_last_newline(char* bytes, size_t len) {
+    char* (*kernel)(char*, size_t) = __atomic_load_n(&find_last_kernel, __ATOMIC_RELAXED);
+    if (kernel == NULL) {
+        pick_kernels();
+        kernel = __atomic_load_n(&find_last_kernel, __ATOMIC_RELAXED);
+    }
+    return kernel(bytes, len);
+}
+
+// count the newlines in a run of bytes
+size_t count_newlines(char* bytes, size_t len) {
+    size_t (*kernel)(char*, size_t) = __atomic_load_n(&count_kernel, __ATOMIC_RELAXED);
+    if (kernel == NULL) {
+        pick_kernels();
+        kernel = __atomic_load_n(&count_kernel, __ATOMIC_RELAXED);
+    }
+    return kernel(bytes, len);
+}
+
+#else
+
+// without the vector kernels there is nothing to pick
+
+// find the first newline in a run of bytes
+char* find_newline(char* bytes, size_t len) {
+    return find_newline_libc(bytes, len);
+}
+
+// find the last newline in a run of bytes
+char* find_last_newline(char* bytes, size_t len) {
+    return find_last_newline_byte(bytes, len);
+}
+
+// count the newlines in a run of bytes
+size_t count_newlines(char* bytes, size_t len) {
+    return count_newlines_word(bytes, len);
+}
+
+#endif
+
+// count the lines in a run of bytes, the last line may not have a newline
+size_t count_lines(char* bytes, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    return count_newlines(bytes, len) + (bytes[len - 1] != '\n');
+}
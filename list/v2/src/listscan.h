@@ -0,0 +1,20 @@
+// header file for listscan.c
+
+#ifndef LISTSCAN_H
+#define LISTSCAN_H
+
+#include <stddef.h>
+
+// find the first newline in a run of bytes, returns null if there is none
+char* find_newline (char* bytes, size_t len);
+
+// find the last newline in a run of bytes, returns null if there is none
+char* find_last_newline (char* bytes, size_t len);
+
+// count the newlines in a run of bytes
+size_t count_newlines (char* bytes, size_t len);
+
+// count the lines in a run of bytes, every newline ends a line and so does the end of the bytes
+size_t count_lines (char* bytes, size_t len);
+
+#endif
@@ -0,0 +1,537 @@
+// sort library
+// numbers are sorted with a radix sort over (number, item) pairs,
+// strings with a stable merge sort over (prefix, length, pointer) records, merged by several threads for big lists
+
+#include "listsort.h"
+#include "liststat.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// parse an item as a signed 64 bit integer
+// spaces, tabs and line endings around the number are allowed, a blank item counts as 0 like it always has.
+// returns 0 if the item is not a number or does not fit in 64 bits and 1 if it is
+int parse_number(char *str, long long *number) {
+    // if the string is missing, return 0
+    if (str == NULL) {
+        return 0;
+    }
+    while (*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n') {
+        str++;
+    }
+    int negative = 0;
+    if (*str == '-' || *str == '+') {
+        negative = *str == '-';
+        str++;
+    }
+    else if (*str == '\0') {
+        *number = 0;
+        return 1;
+    }
+    // add up the digits as a magnitude, which may be one past the largest positive value for a negative number
+    unsigned long long magnitude = 0;
+    unsigned long long limit = negative ? 9223372036854775808ULL : 9223372036854775807ULL;
+    char *digits = str;
+    while (isdigit((unsigned char) *str)) {
+        unsigned long long digit = *str - '0';
+        if (magnitude > (limit - digit) / 10) {
+            return 0;
+        }
+        magnitude = magnitude * 10 + digit;
+        str++;
+    }
+    // a sign needs at least one digit after it
+    if (str == digits) {
+        return 0;
+    }
+    while (*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n') {
+        str++;
+    }
+    if (*str != '\0') {
+        return 0;
+    }
+    *number = negative ? (long long) (0 - magnitude) : (long long) magnitude;
+    return 1;
+}
+
+// a number and the item it came from, sorted by the number
+typedef struct sort_pair {
+    unsigned long long key;
+    char* value;
+} sort_pair;
+
+// sort pairs by key with a least significant digit radix sort, SORT_RADIX_BITS bits per pass
+// the keys are measured from the smallest one first, so a list of numbers that are close together
+// needs only as many passes as the width of its range. the sort is stable, so items with the same
+// number keep their order
+// returns 0 on success and -1 if it ran out of memory, the pairs are then left as they were
+static int radix_sort(sort_pair *pairs, int count) {
+    unsigned long long low = pairs[0].key;
+    unsigned long long high = pairs[0].key;
+    for (int i = 1; i < count; i++) {
+        if (pairs[i].key < low) {
+            low = pairs[i].key;
+        }
+        if (pairs[i].key > high) {
+            high = pairs[i].key;
+        }
+    }
+    int bits = 0;
+    while (bits < 64 && (high - low) >> bits != 0) {
+        bits++;
+    }
+    int passes = (bits + SORT_RADIX_BITS - 1) / SORT_RADIX_BITS;
+    // count the digits of every pass in one read of the pairs
+    size_t *counts = counted_calloc((size_t) SORT_RADIX * (passes > 0 ? passes : 1), sizeof(size_t));
+    sort_pair *scratch = counted_malloc(sizeof(sort_pair) * count);
+    if (counts == NULL || scratch == NULL) {
+        counted_free(counts);
+        counted_free(scratch);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        unsigned long long key = pairs[i].key - low;
+        pairs[i].key = key;
+        for (int p = 0; p < passes; p++) {
+            counts[p * SORT_RADIX + ((key >> (p * SORT_RADIX_BITS)) & (SORT_RADIX - 1))]++;
+        }
+    }
+    sort_pair *from = pairs;
+    sort_pair *to = scratch;
+    for (int p = 0; p < passes; p++) {
+        int shift = p * SORT_RADIX_BITS;
+        // turn the counts into where each digit starts
+        size_t *starts = counts + p * SORT_RADIX;
+        size_t start = 0;
+        for (int v = 0; v < SORT_RADIX; v++) {
+            size_t n = starts[v];
+            starts[v] = start;
+            start += n;
+        }
+        for (int i = 0; i < count; i++) {
+            to[starts[(from[i].key >> shift) & (SORT_RADIX - 1)]++] = from[i];
+        }
+        sort_pair *swap = from;
+        from = to;
+        to = swap;
+    }
+    // an odd number of passes leaves the result in the scratch array
+    if (from != pairs) {
+        memcpy(pairs, from, sizeof(sort_pair) * count);
+    }
+    counted_free(counts);
+    counted_free(scratch);
+    return 0;
+}
+
+// sort an array of items by their value as signed 64 bit integers
+int number_sort(char** values, int count, int ascending) {
+    sort_pair *pairs = counted_malloc(sizeof(sort_pair) * (count > 0 ? count : 1));
+    if (pairs == NULL) {
+        return -2;
+    }
+    for (int i = 0; i < count; i++) {
+        long long number;
+        if (!parse_number(values[i], &number)) {
+            counted_free(pairs);
+            return -1;
+        }
+        pairs[i].key = number_key(number, ascending);
+        pairs[i].value = values[i];
+    }
+    if (count > 0 && radix_sort(pairs, count) != 0) {
+        counted_free(pairs);
+        return -2;
+    }
+    for (int i = 0; i < count; i++) {
+        values[i] = pairs[i].value;
+    }
+    counted_free(pairs);
+    return 0;
+}
+
+// turn a number into a key whose unsigned order is the order of the sort
+unsigned long long number_key(long long number, int ascending) {
+    // flipping the sign bit makes the unsigned order of the keys the signed order of the numbers,
+    // and inverting every bit turns it around for a descending sort
+    unsigned long long key = (unsigned long long) number ^ 0x8000000000000000ULL;
+    return ascending ? key : ~key;
+}
+
+// runs this short are sorted by insertion instead of being split further
+#define LEX_INSERTION 16
+
+// read a sort mode by name, returns -1 if the name is not a mode
+int lex_mode(char* name) {
+    if (strcmp(name, "byte") == 0) {
+        return LEX_BYTE;
+    }
+    if (strcmp(name, "nocase") == 0) {
+        return LEX_NOCASE;
+    }
+    if (strcmp(name, "natural") == 0) {
+        return LEX_NATURAL;
+    }
+    if (strcmp(name, "length") == 0) {
+        return LEX_LENGTH;
+    }
+    return -1;
+}
+
+// pack the first 8 bytes of an item into a number that orders like the bytes, shorter items are padded with zeros
+static uint64_t lex_prefix(char* value, size_t len, int nocase) {
+    uint64_t prefix = 0;
+    for (int i = 0; i < 8; i++) {
+        unsigned char c = i < (int) len ? (unsigned char) value[i] : 0;
+        if (nocase) {
+            c = (unsigned char) tolower(c);
+        }
+        prefix = (prefix << 8) | c;
+    }
+    return prefix;
+}
+
+// compare two items byte by byte, from a starting byte
+static int compare_bytes(lex_record *a, lex_record *b, size_t from, int nocase) {
+    size_t len = a->len < b->len ? a->len : b->len;
+    for (size_t i = from; i < len; i++) {
+        int x = (unsigned char) a->value[i];
+        int y = (unsigned char) b->value[i];
+        if (nocase) {
+            x = tolower(x);
+            y = tolower(y);
+        }
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+    }
+    return a->len < b->len ? -1 : a->len > b->len;
+}
+
+// compare two items in natural order
+// runs of digits compare by value, a run with fewer digits after its leading zeros is the smaller number
+static int compare_natural(lex_record *a, lex_record *b) {
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a->len && j < b->len) {
+        unsigned char x = a->value[i];
+        unsigned char y = b->value[j];
+        if (isdigit(x) && isdigit(y)) {
+            // skip the leading zeros, then the longer run is the bigger number
+            while (i < a->len && a->value[i] == '0') {
+                i++;
+            }
+            while (j < b->len && b->value[j] == '0') {
+                j++;
+            }
+            size_t run_a = 0;
+            size_t run_b = 0;
+            while (i + run_a < a->len && isdigit((unsigned char) a->value[i + run_a])) {
+                run_a++;
+            }
+            while (j + run_b < b->len && isdigit((unsigned char) b->value[j + run_b])) {
+                run_b++;
+            }
+            if (run_a != run_b) {
+                return run_a < run_b ? -1 : 1;
+            }
+            int digits = memcmp(a->value + i, b->value + j, run_a);
+            if (digits != 0) {
+                return digits < 0 ? -1 : 1;
+            }
+            i += run_a;
+            j += run_b;
+        }
+        else {
+            if (x != y) {
+                return x < y ? -1 : 1;
+            }
+            i++;
+            j++;
+        }
+    }
+    // the item with bytes left over is the bigger one
+    return (i < a->len) - (j < b->len);
+}
+
+// compare two items by one key
+// the prefix was built for the first key, so only a byte or nocase first key can use it
+static int compare_key(lex_record *a, lex_record *b, int mode, int first) {
+    if (mode == LEX_LENGTH) {
+        return a->len < b->len ? -1 : a->len > b->len;
+    }
+    if (mode == LEX_NATURAL) {
+        return compare_natural(a, b);
+    }
+    if (first) {
+        if (a->prefix != b->prefix) {
+            return a->prefix < b->prefix ? -1 : 1;
+        }
+        // equal prefixes mean the first 8 bytes match, and a shorter item is only padded with zeros
+        // if the other one ends there too
+        if (a->len <= 8 || b->len <= 8) {
+            return a->len < b->len ? -1 : a->len > b->len;
+        }
+        return compare_bytes(a, b, 8, mode == LEX_NOCASE);
+    }
+    return compare_bytes(a, b, 0, mode == LEX_NOCASE);
+}
+
+// compare two items by every key of the order
+static int compare_records(lex_record *a, lex_record *b, lex_order *order);
+
+// compare two items that are not in records yet
+int lex_compare(char* a, size_t a_len, char* b, size_t b_len, lex_order *order) {
+    int nocase = order->modes[0] == LEX_NOCASE;
+    lex_record x = { lex_prefix(a, a_len, nocase), a_len, a };
+    lex_record y = { lex_prefix(b, b_len, nocase), b_len, b };
+    return compare_records(&x, &y, order);
+}
+
+static int compare_records(lex_record *a, lex_record *b, lex_order *order) {
+    int result = 0;
+    for (int k = 0; k < order->keys && result == 0; k++) {
+        result = compare_key(a, b, order->modes[k], k == 0);
+    }
+    // ties are settled by the bytes unless the items should keep their order
+    if (result == 0 && !order->stable) {
+        result = compare_bytes(a, b, 0, 0);
+    }
+    return order->ascending ? result : -result;
+}
+
+// merge two sorted runs into out, taking from the left run on a tie so the sort is stable
+static void merge_runs(lex_record *left, size_t left_count, lex_record *right, size_t right_count, lex_record *out, lex_order *order) {
+    size_t i = 0;
+    size_t j = 0;
+    while (i < left_count && j < right_count) {
+        if (compare_records(&right[j], &left[i], order) < 0) {
+            *out++ = right[j++];
+        }
+        else {
+            *out++ = left[i++];
+        }
+    }
+    memcpy(out, left + i, sizeof(lex_record) * (left_count - i));
+    out += left_count - i;
+    memcpy(out, right + j, sizeof(lex_record) * (right_count - j));
+}
+
+// sort records with a top down merge sort, scratch has room for as many records
+static void merge_sort(lex_record *records, lex_record *scratch, size_t count, lex_order *order) {
+    if (count <= LEX_INSERTION) {
+        for (size_t i = 1; i < count; i++) {
+            lex_record record = records[i];
+            size_t j = i;
+            while (j > 0 && compare_records(&record, &records[j - 1], order) < 0) {
+                records[j] = records[j - 1];
+                j--;
+            }
+            records[j] = record;
+        }
+        return;
+    }
+    size_t half = count / 2;
+    merge_sort(records, scratch, half, order);
+    merge_sort(records + half, scratch + half, count - half, order);
+    // runs that are already in order need no merge
+    if (compare_records(&records[half], &records[half - 1], order) >= 0) {
+        return;
+    }
+    merge_runs(records, half, records + half, count - half, scratch, order);
+    memcpy(records, scratch, sizeof(lex_record) * count);
+}
+
+// one thread's share of a sort, either sorting a run or merging two runs
+typedef struct lex_job {
+    lex_record *records;
+    lex_record *scratch;
+    size_t count;
+    size_t split;
+    lex_order *order;
+} lex_job;
+
+#ifdef _WIN32
+static DWORD WINAPI sort_job(LPVOID arg) {
+#else
+static void* sort_job(void *arg) {
+#endif
+    lex_job *job = arg;
+    if (job->split == 0) {
+        merge_sort(job->records, job->scratch, job->count, job->order);
+    }
+    else {
+        merge_runs(job->records, job->split, job->records + job->split, job->count - job->split, job->scratch, job->order);
+    }
+    return 0;
+}
+
+// run the jobs on threads of their own and wait for all of them
+// a job whose thread cannot be started runs on the calling thread, and so do all of them without memory for the threads
+static void run_jobs(lex_job *jobs, int count) {
+#ifdef _WIN32
+    HANDLE *threads = counted_malloc(sizeof(HANDLE) * count);
+    if (threads == NULL) {
+        for (int i = 0; i < count; i++) {
+            sort_job(&jobs[i]);
+        }
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        threads[i] = CreateThread(NULL, 0, sort_job, &jobs[i], 0, NULL);
+        if (threads[i] == NULL) {
+            sort_job(&jobs[i]);
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (threads[i] != NULL) {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+    }
+#else
+    pthread_t *threads = counted_malloc(sizeof(pthread_t) * count);
+    int *started = counted_malloc(sizeof(int) * count);
+    if (threads == NULL || started == NULL) {
+        counted_free(threads);
+        counted_free(started);
+        for (int i = 0; i < count; i++) {
+            sort_job(&jobs[i]);
+        }
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, sort_job, &jobs[i]) == 0;
+        if (!started[i]) {
+            sort_job(&jobs[i]);
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    counted_free(started);
+#endif
+    counted_free(threads);
+}
+
+// the number of threads to sort with, one per processor up to the maximum
+static int sort_threads(void) {
+    int threads;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    threads = (int) info.dwNumberOfProcessors;
+#else
+    threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    char *limit = getenv("LIST_THREADS");
+    if (limit != NULL && atoi(limit) > 0) {
+        threads = atoi(limit);
+    }
+    if (threads > LEX_THREADS_MAX) {
+        threads = LEX_THREADS_MAX;
+    }
+    return threads > 1 ? threads : 1;
+}
+
+// sort records with several threads
+// every thread sorts one run, then the runs are merged in pairs, each pair by its own thread, until one is left
+static void parallel_sort(lex_record *records, lex_record *scratch, size_t count, int threads, lex_order *order) {
+    size_t *starts = counted_malloc(sizeof(size_t) * (threads + 1));
+    lex_job *jobs = counted_malloc(sizeof(lex_job) * threads);
+    // without memory for the jobs the calling thread sorts on its own
+    if (starts == NULL || jobs == NULL) {
+        counted_free(starts);
+        counted_free(jobs);
+        merge_sort(records, scratch, count, order);
+        return;
+    }
+    for (int t = 0; t <= threads; t++) {
+        starts[t] = count * t / threads;
+    }
+    for (int t = 0; t < threads; t++) {
+        jobs[t].records = records + starts[t];
+        jobs[t].scratch = scratch + starts[t];
+        jobs[t].count = starts[t + 1] - starts[t];
+        jobs[t].split = 0;
+        jobs[t].order = order;
+    }
+    run_jobs(jobs, threads);
+    // merge neighbouring runs back and forth between the two arrays
+    int runs = threads;
+    lex_record *from = records;
+    lex_record *to = scratch;
+    while (runs > 1) {
+        int merges = 0;
+        int next = 0;
+        for (int r = 0; r < runs; r += 2) {
+            if (r + 1 < runs) {
+                jobs[merges].records = from + starts[r];
+                jobs[merges].scratch = to + starts[r];
+                jobs[merges].count = starts[r + 2] - starts[r];
+                jobs[merges].split = starts[r + 1] - starts[r];
+                jobs[merges].order = order;
+                merges++;
+            }
+            else {
+                // an odd run out is carried over as it is
+                memcpy(to + starts[r], from + starts[r], sizeof(lex_record) * (starts[r + 1] - starts[r]));
+            }
+            starts[next++] = starts[r];
+        }
+        starts[next] = count;
+        run_jobs(jobs, merges);
+        runs = next;
+        lex_record *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != records) {
+        memcpy(records, from, sizeof(lex_record) * count);
+    }
+    counted_free(jobs);
+    counted_free(starts);
+}
+
+// sort an array of strings in place
+int lex_sort(char** values, int count, lex_order *order) {
+    if (count < 2) {
+        return 0;
+    }
+    // build the records once, every item's length and prefix is worked out a single time
+    int nocase = order->modes[0] == LEX_NOCASE;
+    lex_record *records = counted_malloc(sizeof(lex_record) * count);
+    lex_record *scratch = counted_malloc(sizeof(lex_record) * count);
+    if (records == NULL || scratch == NULL) {
+        counted_free(records);
+        counted_free(scratch);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        records[i].value = values[i];
+        records[i].len = strlen(values[i]);
+        records[i].prefix = lex_prefix(values[i], records[i].len, nocase);
+    }
+    int threads = count >= LEX_THREADS_MIN ? sort_threads() : 1;
+    if (threads > 1) {
+        parallel_sort(records, scratch, count, threads, order);
+    }
+    else {
+        merge_sort(records, scratch, count, order);
+    }
+    for (int i = 0; i < count; i++) {
+        values[i] = records[i].value;
+    }
+    counted_free(scratch);
+    counted_free(records);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// header file for listsort.c
+
+#ifndef LISTSORT_H
+#define LISTSORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// string orders for sortlex
+// byte compares the bytes of the items, nocase does the same ignoring the case of letters,
+// natural compares runs of digits by their value so "item9" comes before "item10",
+// and length compares the number of bytes
+#define LEX_BYTE 0
+#define LEX_NOCASE 1
+#define LEX_NATURAL 2
+#define LEX_LENGTH 3
+// the most keys one sort can have, a primary key and the keys that break its ties
+#define LEX_KEYS 4
+
+// how to order a list of strings
+// items that tie on every key keep their order if stable is set, otherwise they are put in byte order
+typedef struct lex_order {
+    int modes[LEX_KEYS];
+    int keys;
+    int ascending;
+    int stable;
+} lex_order;
+
+// an item being sorted
+// prefix holds the first 8 bytes of the item (lower cased for nocase) as a big endian number,
+// so most comparisons are one integer compare and never read the item itself
+typedef struct lex_record {
+    uint64_t prefix;
+    size_t len;
+    char* value;
+} lex_record;
+
+// lists with at least this many items are sorted by several threads, one run per thread,
+// and the runs are merged in pairs by threads as well
+#define LEX_THREADS_MIN 100000
+// the most threads a sort uses, LIST_THREADS in the environment sets a lower number
+#define LEX_THREADS_MAX 8
+
+// each radix sort pass moves the pairs by 11 bits of their keys, so a full 64 bit range takes 6 passes
+#define SORT_RADIX_BITS 11
+#define SORT_RADIX (1 << SORT_RADIX_BITS)
+
+// parse an item as a signed 64 bit integer, spaces, tabs and line endings around it are allowed
+// returns 0 if the item is not a number or does not fit in 64 bits and 1 if it is
+int parse_number (char *str, long long *number);
+
+// turn a number into a key whose unsigned order is the order of the sort, ascending or descending
+unsigned long long number_key (long long number, int ascending);
+
+// sort an array of items by their value as signed 64 bit integers, items with the same value keep their order
+// returns -1 if an item is not an integer and -2 if it ran out of memory, the array is then left as it was
+int number_sort (char** values, int count, int ascending);
+
+// sort an array of strings in place
+// returns 0 on success and -1 if it ran out of memory, the array is then left as it was
+int lex_sort (char** values, int count, lex_order *order);
+
+// compare two strings of the given lengths in the order, returns less than, equal to or more than 0
+int lex_compare (char* a, size_t a_len, char* b, size_t b_len, lex_order *order);
+
+// read a sort mode by name, returns -1 if the name is not a mode
+int lex_mode (char* name);
+
+#endif
@@ -0,0 +1,597 @@
+// list server
+// keeps lists in memory and runs commands against them for clients on a unix domain socket
+// so a command does not pay for starting a process, loading the list and writing it back
+//
+// a request is the number of strings that follow it in decimal, then the list file's resolved absolute path,
+// the command and its arguments, each terminated by a null character. the count goes first so an
+// argument can be an empty string.
+// the response is the command's output followed by a null character and the exit code byte,
+// command output never holds a null character since every item is a C string.
+
+#include "listsrv.h"
+#include "listwait.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+// the server needs unix domain sockets, commands always run in process on windows
+int serve(char* program, char* socketpath, int flush_interval) {
+    printf("Error: the list server is not supported on this platform.\n");
+    return 4;
+}
+
+int forward(int argc, char** argv, unsigned char *exitcode) {
+    return -1;
+}
+
+#else
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// a list the server has loaded
+// mtime and size are what the file looked like when the server last read or wrote it.
+// path is resolved by the client, so one file is one served list whatever name it was given
+typedef struct served_list {
+    char *path;
+    list_t *list;
+    time_t mtime;
+    long mtime_nsec;
+    off_t size;
+    struct served_list *next;
+} served_list;
+
+// a client whose waitpop or waitpopback found its list empty
+// it is answered as soon as a command gives the list an item, or once its deadline passes.
+// argv points into request, which holds the client's whole request
+typedef struct waiter {
+    int client;
+    char *request;
+    int argc;
+    char **argv;
+    long long deadline;
+    struct waiter *next;
+} waiter;
+
+// set by the signal handler to stop the server
+static volatile sig_atomic_t stopping = 0;
+
+static void stop_server(int sig) {
+    (void) sig;
+    stopping = 1;
+}
+
+// the sub-second part of a file's modification time, where the platform has one
+static long mtime_nsec(struct stat *st) {
+#if defined(__linux__)
+    return st->st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+// remember what a list file looks like now so outside changes can be spotted, a missing file is all zeroes
+static void stat_list(served_list *entry) {
+    struct stat st;
+    if (stat(entry->path, &st) != 0) {
+        entry->mtime = 0;
+        entry->mtime_nsec = 0;
+        entry->size = 0;
+        return;
+    }
+    entry->mtime = st.st_mtime;
+    entry->mtime_nsec = mtime_nsec(&st);
+    entry->size = st.st_size;
+}
+
+// check whether a list file was changed by someone else since the server last read or wrote it
+static int file_changed(served_list *entry) {
+    struct stat st;
+    if (stat(entry->path, &st) != 0) {
+        return entry->mtime != 0 || entry->mtime_nsec != 0 || entry->size != 0;
+    }
+    return st.st_mtime != entry->mtime || mtime_nsec(&st) != entry->mtime_nsec || st.st_size != entry->size;
+}
+
+// reload a list whose file was changed by someone else while the server had changes for it
+// new items at either end are carried over onto the file as it is now, any other change was made against
+// stored items that may no longer be there and is dropped rather than written over the other change
+// returns 0 if the changes were carried over, 1 if they were dropped and -1 if it ran out of memory,
+// which leaves the served list as it was
+static int reload_list(served_list *entry) {
+    list_t *list = entry->list;
+    list_t *fresh = create_list(entry->path);
+    if (fresh == NULL) {
+        fresh = new_list();
+        if (fresh == NULL) {
+            return -1;
+        }
+    }
+    int dropped = list->dirty || list->start != list->origin || list->end < list->size;
+    if (!dropped) {
+        // pushed items sit in front of the stored ones, the last one pushed first
+        for (int i = list->pushed - 1; i >= 0; i--) {
+            if (push(fresh, get_value(list, i)) != 0) {
+                free_list(fresh);
+                return -1;
+            }
+        }
+        for (int i = list->count - list->appended; i < list->count; i++) {
+            if (append(fresh, get_value(list, i)) != 0) {
+                free_list(fresh);
+                return -1;
+            }
+        }
+    }
+    free_list(list);
+    entry->list = fresh;
+    return dropped;
+}
+
+// write a changed list back to its file
+// returns 0 if the file holds the served list afterwards
+static int flush_list(served_list *entry) {
+    // take turns with commands that run outside the server
+    // without the lock the write could land in the middle of another writer's, the list stays unsaved
+    list_lock lock;
+    if (lock_list(entry->path, &lock) != 0) {
+        fprintf(stderr, "Error: could not lock list file %s.\n", entry->path);
+        return -1;
+    }
+    // the server's changes were made to the file as it last saw it, writing them over a newer file
+    // would lose what the other writer did
+    if (file_changed(entry)) {
+        int reloaded = reload_list(entry);
+        if (reloaded < 0) {
+            unlock_list(&lock);
+            fprintf(stderr, "Error: could not reload list file %s.\n", entry->path);
+            return -1;
+        }
+        if (reloaded > 0) {
+            fprintf(stderr, "Error: list file %s was changed outside the server, its unsaved changes were dropped.\n", entry->path);
+        }
+    }
+    int failed = unsaved(entry->list) && save_list(entry->list, entry->path) != 0;
+    // still under the lock, so no other writer can slip in between the write and the stat
+    if (!failed) {
+        stat_list(entry);
+    }
+    unlock_list(&lock);
+    if (failed) {
+        fprintf(stderr, "Error writing list %s\n", entry->path);
+        return -1;
+    }
+    return 0;
+}
+
+// write every changed list back to its file
+static void flush_lists(served_list *lists) {
+    for (served_list *entry = lists; entry != NULL; entry = entry->next) {
+        if (unsaved(entry->list)) {
+            flush_list(entry);
+        }
+    }
+}
+
+// find a served list by path, loading it if the server has not seen it
+// a list whose file was changed by someone else is reloaded before the command sees it, unsaved changes
+// go through flush_list so they are carried over or dropped under the lock instead of hiding the new file
+// returns null if the file does not exist, unless create is set
+static served_list* find_list(served_list **lists, char* path, int create) {
+    served_list *entry = *lists;
+    while (entry != NULL && strcmp(entry->path, path) != 0) {
+        entry = entry->next;
+    }
+    struct stat st;
+    int exists = stat(path, &st) == 0;
+    if (entry != NULL) {
+        if (exists && (st.st_mtime != entry->mtime || mtime_nsec(&st) != entry->mtime_nsec || st.st_size != entry->size)) {
+            if (unsaved(entry->list)) {
+                flush_list(entry);
+            }
+            else if (reload_list(entry) == 0) {
+                // what the file looked like before it was read, a change since then is picked up next time
+                entry->mtime = st.st_mtime;
+                entry->mtime_nsec = mtime_nsec(&st);
+                entry->size = st.st_size;
+            }
+        }
+        return entry;
+    }
+    if (!exists && !create) {
+        return NULL;
+    }
+    entry = malloc(sizeof(served_list));
+    entry->path = strdup(path);
+    entry->list = create_list(path);
+    if (entry->list == NULL) {
+        entry->list = new_list();
+    }
+    entry->mtime = 0;
+    entry->mtime_nsec = 0;
+    entry->size = 0;
+    stat_list(entry);
+    entry->next = *lists;
+    *lists = entry;
+    return entry;
+}
+
+// read a whole request from a client, count is set to the number of strings after the count
+// returns the number of bytes read, or -1 if the client hung up before the request was complete
+static int read_request(int client, char **request, int *count) {
+    int capacity = 1024;
+    int len = 0;
+    char *buffer = malloc(capacity);
+    // the strings that arrived so far, and how many the request has once its count arrived
+    int scanned = 0;
+    int strings = 0;
+    int expected = -1;
+    for (;;) {
+        for (; scanned < len; scanned++) {
+            if (buffer[scanned] != '\0') {
+                continue;
+            }
+            if (expected < 0) {
+                expected = atoi(buffer);
+                // a count that is not a number of strings is not a request
+                if (expected < 0) {
+                    free(buffer);
+                    return -1;
+                }
+            }
+            else {
+                strings++;
+            }
+        }
+        if (expected >= 0 && strings == expected) {
+            *request = buffer;
+            *count = expected;
+            return len;
+        }
+        if (len == capacity) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity);
+        }
+        ssize_t got = read(client, buffer + len, capacity - len);
+        if (got <= 0) {
+            free(buffer);
+            return -1;
+        }
+        len += got;
+    }
+}
+
+// run a command against a served list and send its output and exit code to the client
+// a wait whose deadline passed is answered with timed_out set instead of running it
+static void answer(int client, served_list *entry, int argc, char** argv, int timed_out) {
+    unsigned char code;
+    // send the command's output straight to the client
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(client, STDOUT_FILENO);
+    if (argc < 3) {
+        printf("Missing argument \"command\", usage: %s <file> [ <command> <args> ] [/v]\n%s /? for help.", argv[0], argv[0]);
+        code = 1;
+    }
+    else if (entry == NULL) {
+        printf("Error: file %s does not exist.\n", argv[1]);
+        code = 1;
+    }
+    // a wait whose deadline passed, the list is still empty
+    else if (timed_out) {
+        printf("List is empty, timed out waiting for an item, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+        code = 2;
+    }
+    else {
+        code = run_command(entry->list, argc, argv);
+    }
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    // the null character ends the output, the exit code follows it
+    char trailer[2] = { '\0', code };
+    write(client, trailer, 2);
+}
+
+// check if a request is a waitpop or waitpopback
+static int is_wait(int argc, char** argv) {
+    return argc >= 3 && (strcmp(argv[2], "waitpop") == 0 || strcmp(argv[2], "/wf") == 0 ||
+        strcmp(argv[2], "waitpopback") == 0 || strcmp(argv[2], "/wb") == 0);
+}
+
+// run one client's request and send back the output and exit code
+// a wait on an empty list is not answered yet, the client joins the end of the waiters instead
+// returns 1 if the client is waiting and must stay open
+static int handle_client(int client, char* program, served_list **lists, waiter **waiters) {
+    char *request;
+    int count;
+    if (read_request(client, &request, &count) < 0) {
+        return 0;
+    }
+    // lay the request out like the program's own arguments, they start after the count
+    int argc = 1;
+    char **argv = malloc(sizeof(char*) * (count + 2));
+    argv[0] = program;
+    char *arg = request + strlen(request) + 1;
+    for (int i = 0; i < count; i++) {
+        argv[argc++] = arg;
+        arg += strlen(arg) + 1;
+    }
+    argv[argc] = NULL;
+
+    served_list *entry = NULL;
+    if (argc >= 3) {
+        int create = strcmp(argv[2], "new") == 0 || strcmp(argv[2], "/nl") == 0;
+        entry = find_list(lists, argv[1], create);
+    }
+    if (entry != NULL && is_wait(argc, argv) && length(entry->list) == 0) {
+        // a timeout that is not valid is reported by run_command, a timeout of 0 gives up right away
+        long timeout = argc > 3 && strcmp(argv[3], "/v") != 0 ? read_timeout(argv[3]) : -1;
+        if (timeout != -2 && timeout != 0) {
+            waiter *wait = malloc(sizeof(waiter));
+            wait->client = client;
+            wait->request = request;
+            wait->argc = argc;
+            wait->argv = argv;
+            wait->deadline = timeout < 0 ? -1 : clock_ms() + timeout;
+            wait->next = NULL;
+            while (*waiters != NULL) {
+                waiters = &(*waiters)->next;
+            }
+            *waiters = wait;
+            return 1;
+        }
+        if (timeout == 0) {
+            answer(client, entry, argc, argv, 1);
+            free(argv);
+            free(request);
+            return 0;
+        }
+    }
+    answer(client, entry, argc, argv, 0);
+    free(argv);
+    free(request);
+    return 0;
+}
+
+// answer the waiters whose list has an item now, oldest first, and the ones whose deadline passed
+// returns the milliseconds until the next deadline, or -1 if no waiter has one
+static long wake_waiters(served_list **lists, waiter **waiters) {
+    long long now = clock_ms();
+    long long next = -1;
+    while (*waiters != NULL) {
+        waiter *wait = *waiters;
+        served_list *entry = find_list(lists, wait->argv[1], 0);
+        int ready = entry == NULL || length(entry->list) > 0;
+        int expired = wait->deadline >= 0 && wait->deadline <= now;
+        if (ready || expired) {
+            answer(wait->client, entry, wait->argc, wait->argv, !ready);
+            close(wait->client);
+            *waiters = wait->next;
+            free(wait->argv);
+            free(wait->request);
+            free(wait);
+            continue;
+        }
+        if (wait->deadline >= 0 && (next < 0 || wait->deadline < next)) {
+            next = wait->deadline;
+        }
+        waiters = &wait->next;
+    }
+    return next < 0 ? -1 : (long) (next - now);
+}
+
+// run the list server
+int serve(char* program, char* socketpath, int flush_interval) {
+    struct sockaddr_un address;
+    if (strlen(socketpath) >= sizeof(address.sun_path)) {
+        printf("Error: socket path %s is too long.\n", socketpath);
+        return 1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketpath);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        printf("Error creating socket %s\n", socketpath);
+        return 4;
+    }
+    // replace a socket left behind by a server that did not shut down cleanly
+    unlink(socketpath);
+    if (bind(server, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(server, 64) != 0) {
+        printf("Error listening on socket %s\n", socketpath);
+        close(server);
+        return 4;
+    }
+
+    // a client that hangs up early must not take the server down with it
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop_server);
+    signal(SIGTERM, stop_server);
+
+    served_list *lists = NULL;
+    waiter *waiters = NULL;
+    long next_deadline = -1;
+    time_t next_flush = time(NULL) + flush_interval;
+    while (!stopping) {
+        // wait for a client, but no longer than the next flush or the next waiter's deadline
+        long wait = (long) (next_flush - time(NULL));
+        wait = wait > 0 ? wait * 1000 : 0;
+        if (next_deadline >= 0 && next_deadline < wait) {
+            wait = next_deadline;
+        }
+        struct pollfd waiting = { server, POLLIN, 0 };
+        int ready = poll(&waiting, 1, wait);
+        if (ready > 0) {
+            int client = accept(server, NULL, NULL);
+            if (client >= 0) {
+                // do not let a stalled client hold up everyone else forever
+                struct timeval timeout = { 5, 0 };
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                if (!handle_client(client, program, &lists, &waiters)) {
+                    close(client);
+                }
+            }
+        }
+        else if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        // the command may have given a waiting client its item
+        next_deadline = wake_waiters(&lists, &waiters);
+        if (time(NULL) >= next_flush) {
+            flush_lists(lists);
+            next_flush = time(NULL) + flush_interval;
+        }
+    }
+    // let the waiting clients go, they see the server go away like any other failure
+    while (waiters != NULL) {
+        waiter *wait = waiters;
+        waiters = wait->next;
+        close(wait->client);
+        free(wait->argv);
+        free(wait->request);
+        free(wait);
+    }
+    // write everything back before going away
+    flush_lists(lists);
+    close(server);
+    unlink(socketpath);
+    return 0;
+}
+
+// connect to the list server named by LIST_SERVER
+// returns the socket, or -1 if there is no server
+static int connect_server(void) {
+    char *socketpath = getenv(SERVER_ENV);
+    struct sockaddr_un address;
+    if (socketpath == NULL || *socketpath == '\0' || strlen(socketpath) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketpath);
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        return -1;
+    }
+    if (connect(server, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        close(server);
+        return -1;
+    }
+    return server;
+}
+
+// write a whole buffer to a socket
+static int write_all(int fd, char *buffer, size_t len) {
+    while (len > 0) {
+        ssize_t done = write(fd, buffer, len);
+        if (done <= 0) {
+            return -1;
+        }
+        buffer += done;
+        len -= done;
+    }
+    return 0;
+}
+
+// find the absolute path of a list file with every ".", ".." and symbolic link resolved,
+// so each list has one name on the server however a client spells it.
+// a list that does not exist yet has its directory resolved instead
+// returns the path in a new buffer, or null if the directory does not exist
+static char* resolve_path(char* path) {
+    char *resolved = realpath(path, NULL);
+    if (resolved != NULL) {
+        return resolved;
+    }
+    char *slash = strrchr(path, '/');
+    char *name = slash != NULL ? slash + 1 : path;
+    char *directory;
+    if (slash == NULL) {
+        directory = realpath(".", NULL);
+    }
+    else if (slash == path) {
+        directory = realpath("/", NULL);
+    }
+    else {
+        char *parent = strndup(path, slash - path);
+        directory = realpath(parent, NULL);
+        free(parent);
+    }
+    if (directory == NULL) {
+        return NULL;
+    }
+    resolved = malloc(strlen(directory) + strlen(name) + 2);
+    sprintf(resolved, "%s%s%s", directory, strcmp(directory, "/") == 0 ? "" : "/", name);
+    free(directory);
+    return resolved;
+}
+
+// forward a command to the list server
+int forward(int argc, char** argv, unsigned char *exitcode) {
+    int server = connect_server();
+    if (server < 0) {
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // the server runs in another directory, so send it the resolved absolute path of the list
+    char *absolute = resolve_path(argv[1]);
+    char *path = absolute != NULL ? absolute : argv[1];
+    // the count of strings goes first, the path and then every argument after the list file
+    char count[16];
+    sprintf(count, "%d", argc - 1);
+    int failed = write_all(server, count, strlen(count) + 1) != 0;
+    if (!failed) {
+        failed = write_all(server, path, strlen(path) + 1) != 0;
+    }
+    for (int i = 2; i < argc && !failed; i++) {
+        failed = write_all(server, argv[i], strlen(argv[i]) + 1) != 0;
+    }
+    free(absolute);
+
+    // print the output as it arrives, holding back the last two bytes until we know they are not the trailer
+    char buffer[65536];
+    char held[2];
+    int held_len = 0;
+    ssize_t got;
+    while (!failed && (got = read(server, buffer, sizeof(buffer))) > 0) {
+        // release whatever was held back, it is output now that more bytes arrived
+        if (got >= 2) {
+            fwrite(held, 1, held_len, stdout);
+            fwrite(buffer, 1, got - 2, stdout);
+            held[0] = buffer[got - 2];
+            held[1] = buffer[got - 1];
+            held_len = 2;
+        }
+        else if (held_len == 2) {
+            fputc(held[0], stdout);
+            held[0] = held[1];
+            held[1] = buffer[0];
+        }
+        else {
+            held[held_len++] = buffer[0];
+        }
+    }
+    close(server);
+    if (failed || held_len != 2 || held[0] != '\0') {
+        printf("Error: the list server did not answer.\n");
+        *exitcode = 4;
+        return 0;
+    }
+    *exitcode = (unsigned char) held[1];
+    return 0;
+}
+
+#endif
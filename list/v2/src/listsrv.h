@@ -0,0 +1,26 @@
+// header file for listsrv.c
+
+#ifndef LISTSRV_H
+#define LISTSRV_H
+
+#include "listlib.h"
+
+// the environment variable that holds the socket path of a running list server
+#define SERVER_ENV "LIST_SERVER"
+
+// how often the server writes changed lists back to their files, in seconds
+#define SERVER_FLUSH 1
+
+// run one command against a loaded list, provided by main.c
+int run_command (list_t *list, int argc, char** argv);
+
+// run the list server on a unix domain socket until it is stopped with SIGINT or SIGTERM
+// lists are kept in memory and written back every flush_interval seconds and on shutdown
+// returns the exit code for the process
+int serve (char* program, char* socketpath, int flush_interval);
+
+// forward a command to the list server named by LIST_SERVER and print its output
+// returns 0 with the command's exit code in exitcode, or -1 if no server is running
+int forward (int argc, char** argv, unsigned char *exitcode);
+
+#endif
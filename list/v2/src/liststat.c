@@ -0,0 +1,207 @@
+// list stats library
+// counts what the list library does, so a slow command shows whether reading the list, the command itself
+// or writing the list back took the time, and how many bytes, system calls and allocations it cost
+
+#include "liststat.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+LIST_THREAD list_stats library_stats = { .syscall_reads = -1, .syscall_writes = -1, .peak_rss = -1 };
+LIST_THREAD list_allocator *library_allocator = NULL;
+
+// the phase being timed and when it started
+static LIST_THREAD int current_phase = STAT_NONE;
+static LIST_THREAD double phase_wall;
+static LIST_THREAD double phase_cpu;
+
+// the wall clock in microseconds, only the difference between two calls means anything
+static double wall_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double) count.QuadPart * 1000000.0 / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#endif
+}
+
+// the processor time the process has used in microseconds, user and system together
+static double cpu_us(void) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        return 0;
+    }
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    // filetimes count 100 nanosecond ticks
+    return (double) (k.QuadPart + u.QuadPart) / 10.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec * 1000000.0 + usage.ru_utime.tv_usec + usage.ru_stime.tv_sec * 1000000.0 + usage.ru_stime.tv_usec;
+#endif
+}
+
+void stats_reset(void) {
+    memset(&library_stats, 0, sizeof(list_stats));
+    library_stats.syscall_reads = -1;
+    library_stats.syscall_writes = -1;
+    library_stats.peak_rss = -1;
+    current_phase = STAT_NONE;
+}
+
+void stats_phase(int phase) {
+    double wall = wall_us();
+    double cpu = cpu_us();
+    // the phase that was being timed ends now
+    if (current_phase != STAT_NONE) {
+        library_stats.wall[current_phase] += wall - phase_wall;
+        library_stats.cpu[current_phase] += cpu - phase_cpu;
+    }
+    current_phase = phase;
+    phase_wall = wall;
+    phase_cpu = cpu;
+}
+
+list_stats* stats_snapshot(void) {
+    // close the running phase so its time so far is counted, and keep timing it
+    if (current_phase != STAT_NONE) {
+        stats_phase(current_phase);
+    }
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        library_stats.peak_rss = (long long) (memory.PeakWorkingSetSize / 1024);
+    }
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(GetCurrentProcess(), &io)) {
+        library_stats.syscall_reads = (long long) io.ReadOperationCount;
+        library_stats.syscall_writes = (long long) io.WriteOperationCount;
+    }
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        // macos reports bytes, everyone else kilobytes
+        library_stats.peak_rss = usage.ru_maxrss / 1024;
+#else
+        library_stats.peak_rss = usage.ru_maxrss;
+#endif
+    }
+#ifdef __linux__
+    // the kernel counts every read and write system call of the process
+    FILE *io = fopen("/proc/self/io", "r");
+    if (io != NULL) {
+        char line[128];
+        long long value;
+        while (fgets(line, sizeof(line), io) != NULL) {
+            if (sscanf(line, "syscr: %lld", &value) == 1) {
+                library_stats.syscall_reads = value;
+            }
+            else if (sscanf(line, "syscw: %lld", &value) == 1) {
+                library_stats.syscall_writes = value;
+            }
+        }
+        fclose(io);
+    }
+#endif
+#endif
+    return &library_stats;
+}
+
+void stats_print(FILE *out, char* command) {
+    list_stats *s = stats_snapshot();
+    char *names[STAT_PHASES] = { "parse", "operation", "write" };
+    fprintf(out, "{\"command\": \"");
+    // the command is the user's text, keep the JSON valid whatever it holds
+    for (char *c = command; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+        }
+        if ((unsigned char) *c >= 0x20) {
+            fputc(*c, out);
+        }
+    }
+    fprintf(out, "\"");
+    double wall = 0;
+    double cpu = 0;
+    for (int i = 0; i < STAT_PHASES; i++) {
+        fprintf(out, ", \"%s\": {\"wall_us\": %.0f, \"cpu_us\": %.0f}", names[i], s->wall[i], s->cpu[i]);
+        wall += s->wall[i];
+        cpu += s->cpu[i];
+    }
+    fprintf(out, ", \"total\": {\"wall_us\": %.0f, \"cpu_us\": %.0f}", wall, cpu);
+    fprintf(out, ", \"bytes_read\": %llu, \"bytes_written\": %llu, \"bytes_mapped\": %llu",
+        s->bytes_read, s->bytes_written, s->bytes_mapped);
+    fprintf(out, ", \"syscalls\": {\"read\": %lld, \"write\": %lld, \"open\": %llu, \"mmap\": %llu, \"rename\": %llu, \"lock\": %llu}",
+        s->syscall_reads, s->syscall_writes, s->opens, s->maps, s->renames, s->locks);
+    fprintf(out, ", \"allocations\": %llu, \"peak_rss_kb\": %lld}\n", s->allocations, s->peak_rss);
+    fflush(out);
+}
+
+// count an allocation that came back empty, asking for no bytes may give null without running out
+static void* count_failure(void *block, size_t size) {
+    if (block == NULL && size > 0) {
+        library_stats.failed_allocations++;
+    }
+    return block;
+}
+
+void* counted_malloc(size_t size) {
+    library_stats.allocations++;
+    if (library_allocator != NULL) {
+        return count_failure(library_allocator->allocate(library_allocator->context, size), size);
+    }
+    return count_failure(malloc(size), size);
+}
+
+void* counted_realloc(void *block, size_t size) {
+    library_stats.allocations++;
+    if (library_allocator != NULL) {
+        return count_failure(library_allocator->reallocate(library_allocator->context, block, size), size);
+    }
+    return count_failure(realloc(block, size), size);
+}
+
+void* counted_calloc(size_t count, size_t size) {
+    library_stats.allocations++;
+    if (library_allocator != NULL) {
+        // an allocator only has to hand out memory, clearing it is done here
+        if (size != 0 && count > (size_t) -1 / size) {
+            return count_failure(NULL, size);
+        }
+        void *block = library_allocator->allocate(library_allocator->context, count * size);
+        if (block != NULL) {
+            memset(block, 0, count * size);
+        }
+        return count_failure(block, count * size);
+    }
+    return count_failure(calloc(count, size), count * size);
+}
+
+void counted_free(void *block) {
+    if (block == NULL) {
+        return;
+    }
+    if (library_allocator != NULL) {
+        library_allocator->release(library_allocator->context, block);
+        return;
+    }
+    free(block);
+}
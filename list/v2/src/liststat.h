@@ -0,0 +1,91 @@
+// header file for liststat.c
+
+#ifndef LISTSTAT_H
+#define LISTSTAT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// the phases of a command
+// parse is reading the list, from opening the file to having every item, operation is running the command
+// and write is putting the changes back in the file
+#define STAT_PARSE 0
+#define STAT_OPERATION 1
+#define STAT_WRITE 2
+#define STAT_PHASES 3
+// no phase is being timed
+#define STAT_NONE -1
+
+// the environment variable that turns on the stats report like the --stats option, set it to 1
+#define STATS_ENV "LIST_STATS"
+
+// the counters and the allocator belong to the thread using the library, so programs that work on lists
+// from several threads never share them. compilers without thread local storage share them between threads
+#if defined(_MSC_VER)
+#define LIST_THREAD __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define LIST_THREAD __thread
+#else
+#define LIST_THREAD
+#endif
+
+// what the list library has done so far in this process
+// wall and cpu are in microseconds for each phase. bytes_read and bytes_written count list and sidecar file
+// bytes moved by read and write calls, bytes_mapped the bytes of files mapped instead of read.
+// opens, maps, renames and locks count the file system calls the library made, allocations its heap allocations
+// and failed_allocations those that ran out of memory.
+// syscall_reads, syscall_writes and peak_rss (in kilobytes) come from the operating system for the whole process
+// when stats_snapshot is called, they are -1 where the platform does not report them
+typedef struct list_stats {
+    double wall[STAT_PHASES];
+    double cpu[STAT_PHASES];
+    unsigned long long bytes_read;
+    unsigned long long bytes_written;
+    unsigned long long bytes_mapped;
+    unsigned long long opens;
+    unsigned long long maps;
+    unsigned long long renames;
+    unsigned long long locks;
+    unsigned long long allocations;
+    unsigned long long failed_allocations;
+    long long syscall_reads;
+    long long syscall_writes;
+    long long peak_rss;
+} list_stats;
+
+// the counters of this thread, the library adds to them as it goes
+extern LIST_THREAD list_stats library_stats;
+
+// an allocator a program embedding the library hands it, context is passed back on every call
+// allocate and reallocate return null when they run out of memory like malloc and realloc
+typedef struct list_allocator {
+    void* (*allocate)(void *context, size_t size);
+    void* (*reallocate)(void *context, void *block, size_t size);
+    void (*release)(void *context, void *block);
+    void *context;
+} list_allocator;
+
+// the allocator the library allocates through on this thread, null uses malloc, realloc and free
+// listapi points it at the allocator of a handle for the length of each call
+extern LIST_THREAD list_allocator *library_allocator;
+
+// clear every counter and stop timing
+void stats_reset (void);
+
+// start timing a phase, the phase being timed before it stops. STAT_NONE stops timing
+void stats_phase (int phase);
+
+// fill in the counters that come from the operating system and return the counters
+list_stats* stats_snapshot (void);
+
+// print the counters as one JSON object on a line of its own
+void stats_print (FILE *out, char* command);
+
+// heap allocation through library_allocator that counts itself in library_stats.allocations
+// they return null when the allocator runs out of memory and count that in library_stats.failed_allocations
+void* counted_malloc (size_t size);
+void* counted_realloc (void *block, size_t size);
+void* counted_calloc (size_t count, size_t size);
+void counted_free (void *block);
+
+#endif
@@ -0,0 +1,219 @@
+// list watch library
+// lets a command sleep until a list file changes instead of checking it in a loop
+// linux is told about changes by inotify and windows by a change notification on the directory,
+// other systems check the file's size and modification time every WATCH_POLL milliseconds
+
+#include "listwait.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#endif
+
+// read a timeout in seconds, fractions of a second are allowed
+// returns the timeout in milliseconds, or -2 if the text is not a number of seconds
+long read_timeout(char* text) {
+    char *end;
+    double seconds = strtod(text, &end);
+    if (end == text || *end != '\0' || seconds < 0 || seconds > 2000000) {
+        return -2;
+    }
+    return (long) (seconds * 1000);
+}
+
+#if defined(_WIN32) || defined(__linux__)
+// split a file name into the directory that holds it and the name inside that directory
+// returns the directory, the caller frees it
+static char* watch_directory(char* filename, char **name) {
+    char *slash = strrchr(filename, '/');
+#ifdef _WIN32
+    char *backslash = strrchr(filename, '\\');
+    if (backslash != NULL && (slash == NULL || backslash > slash)) {
+        slash = backslash;
+    }
+#endif
+    if (slash == NULL) {
+        *name = filename;
+        return strdup(".");
+    }
+    *name = slash + 1;
+    // a file in the root directory keeps its slash
+    size_t len = slash == filename ? 1 : slash - filename;
+    char *directory = malloc(len + 1);
+    memcpy(directory, filename, len);
+    directory[len] = '\0';
+    return directory;
+}
+#endif
+
+#ifdef _WIN32
+
+long long clock_ms(void) {
+    return (long long) GetTickCount64();
+}
+
+int watch_list(char* filename, list_watch *watch) {
+    char *name;
+    char *directory = watch_directory(filename, &name);
+    watch->name = strdup(name);
+    watch->change = FindFirstChangeNotificationA(directory, FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    free(directory);
+    if (watch->change == INVALID_HANDLE_VALUE) {
+        watch->change = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// the notification does not say which file changed, so any change in the directory wakes the caller
+int wait_change(list_watch *watch, long timeout) {
+    if (watch->change == NULL) {
+        Sleep(timeout < 0 || timeout > WATCH_POLL ? WATCH_POLL : timeout);
+        return 1;
+    }
+    DWORD result = WaitForSingleObject(watch->change, timeout < 0 ? INFINITE : (DWORD) timeout);
+    if (result != WAIT_OBJECT_0) {
+        return 0;
+    }
+    FindNextChangeNotification(watch->change);
+    return 1;
+}
+
+void unwatch_list(list_watch *watch) {
+    if (watch->change != NULL) {
+        FindCloseChangeNotification(watch->change);
+    }
+    free(watch->name);
+    memset(watch, 0, sizeof(list_watch));
+}
+
+#else
+
+long long clock_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// remember what the watched file looks like now, returns 1 if that is not what it looked like before
+static int stat_watch(list_watch *watch, char* filename) {
+    struct stat st;
+    long long mtime = 0;
+    long long size = -1;
+    long long inode = 0;
+    if (stat(filename, &st) == 0) {
+#if defined(__APPLE__)
+        mtime = (long long) st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        mtime = (long long) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        size = st.st_size;
+        inode = st.st_ino;
+    }
+    int changed = mtime != watch->mtime || size != watch->size || inode != watch->inode;
+    watch->mtime = mtime;
+    watch->size = size;
+    watch->inode = inode;
+    return changed;
+}
+
+int watch_list(char* filename, list_watch *watch) {
+    memset(watch, 0, sizeof(list_watch));
+    watch->fd = -1;
+#ifdef __linux__
+    char *name;
+    char *directory = watch_directory(filename, &name);
+    watch->fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    // an append or a front push changes the file in place, every other change renames a new file over it
+    if (watch->fd >= 0 && inotify_add_watch(watch->fd, directory, IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(watch->fd);
+        watch->fd = -1;
+    }
+    if (watch->fd >= 0) {
+        watch->name = strdup(name);
+        free(directory);
+        return 0;
+    }
+    free(directory);
+#endif
+    // without inotify the file is checked on a timer
+    watch->name = strdup(filename);
+    stat_watch(watch, filename);
+    return 0;
+}
+
+#ifdef __linux__
+// read the waiting inotify events, returns 1 if one of them was about the watched file
+static int read_events(list_watch *watch) {
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+    ssize_t got;
+    while ((got = read(watch->fd, buffer, sizeof(buffer))) > 0) {
+        for (char *pos = buffer; pos < buffer + got; ) {
+            struct inotify_event *event = (struct inotify_event *) pos;
+            if (event->len > 0 && strcmp(event->name, watch->name) == 0) {
+                changed = 1;
+            }
+            pos += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+#endif
+
+int wait_change(list_watch *watch, long timeout) {
+    long long deadline = timeout < 0 ? -1 : clock_ms() + timeout;
+    for (;;) {
+        long long left = deadline < 0 ? -1 : deadline - clock_ms();
+        if (deadline >= 0 && left < 0) {
+            left = 0;
+        }
+#ifdef __linux__
+        if (watch->fd >= 0) {
+            // sleep until the directory changes, then check the change was to the list file
+            struct pollfd waiting = { watch->fd, POLLIN, 0 };
+            int ready = poll(&waiting, 1, (int) left);
+            if (ready < 0 && errno != EINTR) {
+                return 1;
+            }
+            if (ready > 0 && read_events(watch)) {
+                return 1;
+            }
+            if (ready == 0) {
+                return 0;
+            }
+            continue;
+        }
+#endif
+        if (stat_watch(watch, watch->name)) {
+            return 1;
+        }
+        if (left == 0) {
+            return 0;
+        }
+        struct timespec pause = { 0, WATCH_POLL * 1000000L };
+        nanosleep(&pause, NULL);
+    }
+}
+
+void unwatch_list(list_watch *watch) {
+    if (watch->fd >= 0) {
+        close(watch->fd);
+    }
+    free(watch->name);
+    memset(watch, 0, sizeof(list_watch));
+    watch->fd = -1;
+}
+
+#endif
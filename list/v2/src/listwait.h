@@ -0,0 +1,42 @@
+// header file for listwait.c
+
+#ifndef LISTWAIT_H
+#define LISTWAIT_H
+
+// a watch on a list file, reports when the file may have changed
+// the directory is watched rather than the file, since a rewritten list file is renamed over the old one
+// and a watch on the old file would never hear about it
+typedef struct list_watch {
+    char *name;
+#ifdef _WIN32
+    void *change;
+#else
+    int fd;
+    long long mtime;
+    long long size;
+    long long inode;
+#endif
+} list_watch;
+
+// how often the watch checks the file where the platform cannot report changes, in milliseconds
+#define WATCH_POLL 1
+
+// read a timeout in seconds, fractions of a second are allowed
+// returns the timeout in milliseconds, or -2 if the text is not a number of seconds
+long read_timeout (char* text);
+
+// the current time in milliseconds, only the difference between two calls means anything
+long long clock_ms (void);
+
+// start watching a list file, returns 0 on success and -1 if the file cannot be watched
+int watch_list (char* filename, list_watch *watch);
+
+// wait until the watched file may have changed, or for timeout milliseconds, a negative timeout waits forever
+// returns 1 if something changed and 0 if the time ran out
+// a change can be reported that does not touch the list, the caller checks the list again either way
+int wait_change (list_watch *watch, long timeout);
+
+// stop watching a list file
+void unwatch_list (list_watch *watch);
+
+#endif
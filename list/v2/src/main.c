@@ -1,537 +1,1518 @@
-// List Plugin
-// By Zeek Halkyr
-// 2/5/22
-
-#include "listlib.h"
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-// developer notes:
-// the runaway label is used to break out of the loop and quickly close the file and exit.
-// if the list file does not exist, the program will exit with an error. I have added a flag called "/nl" to create a new list, but referencing any file with the format works.
-
-int main(int argc, char** argv) {
-    unsigned char exitcode = 0; // will exit with this code
-    // if the first argument is -?, --?, /? or ? then print the help message
-    if (argc == 2 && (strcmp(argv[1], "-?") == 0 || strcmp(argv[1], "--?") == 0 || strcmp(argv[1], "/?") == 0 || strcmp(argv[1], "?") == 0)) {
-        printf("\nlist.exe by Zeek Halkyr - a list program that can be used to manipulate data\n");
-        printf("\n");
-        printf("Usage: list [filename] [option] [arguments] [/v] \n\n");
-        printf("Lists are stored in a text file that is the first argument. The file is expected to exist, you can create a list with the /nl or new flag.\n");
-        printf("The list file will be automatically updated after execution.\n");
-        printf("You can specify any file that has strings separate by newlines. Each line is a separate item in the list.\n");
-        printf("It is recommended to encapsulate strings in quotes.\n\n");
-        printf("Options (batch-style flag | alternative style, parameters are the same): \n");
-        printf("\t/v  | verbose - use as the final argument, extends logging level\n");
-        printf("\t/af | push <value> - push an item to the front of the list\n"); 
-        printf("\t/rf | pop - pop an item from the front of the list and return it\n");
-        printf("\t/ab | append <value> - append an item to the end of the list\n");
-        printf("\t/rb | popback - pop an item from the end of the list and return it\n");
-        printf("\t/ra | remove <index> - remove an item by index and return it\n");
-        printf("\t/rw | removewhere <value> - remove an item by value, notifies if not found\n");
-        printf("\t/gi | get <index> - print the value stored at an index\n");
-        printf("\t/gl | print - print the entire list, each item on a newline\n");
-        printf("\t/ia | insert <index> <value> - insert an item at an index, the previous item at that index is pushed to to the right/down\n");
-        printf("\t/fv | find <value> - find a value and return its index, notifies if not found\n");
-        printf("\t/ll | getlength - get the length of the list in number of elements\n");
-        printf("\t/il | sizeof <index> - get the length of a value in the list. returns both characters and bytes size in verbose mode\n");
-        printf("\t/nl | new <filename> - new list, creates a new list with the specified name\n\n");
-        printf("\t/rs | reverse - reverse the list\n");
-        printf("\t/ps | pushset <space separated items> <0/1> - push any number of items to the list, the final argument is 0 for front 1 for back.\n");
-        printf("\t/rs | removeset <space separated items> <0/1> - remove any number of items from the list, it will report if a item is not found and remove the rest.\n");
-        printf("\t/ss | sortstr <0/1> - sort the list by string length. 0 for ascending 1 for descending. \n");
-        printf("\t/si | sort <0/1> - sort the list by number. 0 for ascending 1 for descending. Non-integer values will throw an error. \n");
-        printf("Examples: \n");
-        printf("\tlist.exe list.txt /af \"hello\"\n");
-        printf("\tlist.exe list.txt /rf\n");
-        printf("\tlist.exe list.txt /gi 3\n");
-        printf("\tlist.exe list.txt /il 8\n");
-        printf("Exit Codes:\n");
-        printf("\t0 - OK\n");
-        printf("\t1 - ARG_FAILURE (Missing argument or invalid filename)\n");
-        printf("\t2 - EMPTY_LIST (Value not found or the list was empty)\n");
-        printf("\t3 - INDEX_OUT_OF_BOUNDS (Negative integer or too large)\n");
-        printf("\t4 - FILE_ERROR (Couldn't create a new file, general fault)\n");
-        printf("\t5 - NO_COMMAND (Invalid or missing command)\n");
-        printf("Notes:\n");
-        printf("\tThe program will error if the list file does not exist. Use /nl \n");
-        exit(0);
-    }
-    // check if we have a list file
-    node *head = NULL;
-    if (argc == 2) {
-        // there isn't a command, error
-        printf("Error: no command specified, usage: %s <file> [ <command> <args> ] [/v]\n%s /? for help.", argv[0], argv[0]);
-        exit(1);
-    }
-    // if we have more than two arguments:
-    if (argc > 2) {
-        // if the second argument is /nl we are trying to create a new list, goto escape
-        if (strcmp(argv[2], "/nl") == 0 || strcmp(argv[2], "new") == 0) {
-            goto escape;
-        }
-        // else, if the file doesn't exist, report an error and exit
-        FILE *fp = fopen(argv[1], "r");
-        if (fp == NULL) {
-            printf("Error: file %s does not exist.\n", argv[1]);
-            exit(1);
-        }
-
-    }
-    escape:
-
-    // check that we have at least two arguments
-    if (argc < 3) {
-        printf("Missing argument \"command\", usage: %s <file> [ <command> <args> ] [/v]\n%s /? for help.", argv[0], argv[0]);
-        exitcode = 1;
-        goto runaway;
-    }
-    // if the last argument (argv[argc-1]) is "/v", set the verbose flag to true
-    int verbose = 0;
-    if (strcmp(argv[argc-1], "/v") == 0 || strcmp(argv[2], "new") == 0) {
-        verbose = 1;
-    }
-
-    // create the list
-    head = create_list(argv[1]);
-    // switch on the command (the second argument)
-    if (strcmp(argv[2], "push") == 0 || strcmp(argv[2], "/af") == 0) {
-        // push the third argument to the front of the list
-        // if we dont have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"push-item\", Usage: %s <file> [ <command> <args> ]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        push(&head, argv[3]);
-        // notify if verbose
-        if (verbose) {
-            printf("Pushed \"%s\" to the front of the list\n", argv[3]);
-        }
-        
-    }
-
-    else if (strcmp(argv[2], "pop") == 0 || strcmp(argv[2], "/rf") == 0) {
-        // pop the first node from the list
-        char* value = pop(&head);
-        // if the value is null, throw error
-        if (value == NULL) {
-            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 2;
-            goto runaway;
-        }
-        // notify if verbose
-        if (verbose) {
-            printf("Popped \"%s\" from the front of the list\n", value);
-        }
-        // else just print the value
-        else {
-            printf("%s\n", value);
-        }
-    }
-
-    else if (strcmp(argv[2], "append") == 0 || strcmp(argv[2], "/ab") == 0) {
-        // append an item to the end of the list
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"append-item\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        append(&head, argv[3]);
-        // notify if verbose
-        if (verbose) {
-            printf("Appended \"%s\" to the end of the list\n", argv[3]);
-        }
-
-    }
-
-    else if (strcmp(argv[2], "popback") == 0 || strcmp(argv[2], "/rb") == 0 ) {
-        // popback an item from the end of the list
-        char* value = pop_end(&head);
-        // if the value is null, throw error
-        if (value == NULL) {
-            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        // notify if verbose
-        if (verbose) {
-            printf("Popped \"%s\" from the end of the list\n", value);
-        }
-        // else just print the value
-        else {
-            printf("%s\n", value);
-        }
-    }
-
-    else if (strcmp(argv[2], "remove") == 0 || strcmp(argv[2], "/ra") == 0) {
-        // remove an item from the list at the index in argument 3
-        // behavior is undefined for a alphanumeric passed
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"remove-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        char* value = rem_index(&head, atoi(argv[3]));
-        // if the value is null it is out of bounds
-        if (value == NULL) {
-            printf("Index %i out of bounds, Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
-            exitcode = 3;
-            goto runaway;
-        }
-        // notify if verbose
-        if (verbose) {
-            printf("Removed \"%s\" from the list at index %i\n", value, atoi(argv[3]));
-        }
-        // else
-        else {
-            printf("%s\n", value);
-        }
-    }
-
-    else if (strcmp(argv[2], "removewhere") == 0 || strcmp(argv[2], "/rw") == 0) {
-        // remove an item from the list where the value is the third argument
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"remove-value-string\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        char* value = rem_value(&head, argv[3]);
-        // if the value is null it is not in the list or the list is empty
-        if (value == NULL) {
-            printf("Value \"%s\" not in list.\n", argv[3], argv[0]);
-            exitcode = 2;
-            goto runaway;
-        }
-        // notify if verbose
-        if (verbose) {
-            printf("Removed \"%s\" from the list at %i\n", value, atoi(argv[3]));
-        }
-        // else
-        else {
-            printf("%s\n", value);
-        }
-    }
-
-    else if (strcmp(argv[2], "get") == 0 || strcmp(argv[2], "/gi") == 0) {
-        // get a specific index in the list and print it
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"get-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;      
-            goto runaway;
-        }
-        int l = print_index(head, atoi(argv[3]));
-        if (l == -1) {
-            printf("Index %i out of bounds (EMPTY_LIST), Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
-            exitcode = 2;
-            goto runaway;
-        }
-        if (l == -2) {
-            printf("Index %i out of bounds (NEGATIVE_INDEX), Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
-            exitcode = 3;
-            goto runaway;
-        }
-        if (l == -3) {
-            printf("Index %i out of bounds (TOO_BIG - remember the list is zero-indexed), Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
-            exitcode = 3;
-            goto runaway;
-        }
-
-    }
-
-    else if (strcmp(argv[2], "print") == 0 || strcmp(argv[2], "/gl") == 0) {
-        // print the entire list to the screen
-        print_list(head);
-    }
-
-    else if (strcmp(argv[2], "insert") == 0 || strcmp(argv[2], "/ia") == 0) {
-        // insert the item at argument 4 at the index in argument 3
-        // if argument 3 is not an integer, behavior is undefined
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"insert-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        // if we do not have a fourth argument, throw error
-        if (argc < 5) {
-            printf("Missing argument \"insert-item\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        insert_index(&head, atoi(argv[3]), argv[4]);
-        // notify if verbose
-        if (verbose) {
-            printf("Inserted \"%s\" at index %i\n", argv[4], atoi(argv[3]));
-        }
-    }
-
-    else if (strcmp(argv[2], "find") == 0 || strcmp(argv[2], "/fv") == 0) {
-        // find a value using index_of, the third argument is the value to find
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"find-value-string\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        int index = index_of(head, argv[3]);
-        // if the index is -1, the value is not in the list
-        if (index == -1) {
-            printf("Value \"%s\" not in list.\n", argv[3], argv[0]);    
-            exitcode = 2;
-            goto runaway;
-        }
-        // if we are not verbose simply print the index
-        if (!verbose) {
-            printf("%i\n", index);
-        }
-        // else print the index and the value
-        else {
-            printf("%i: %s\n", index, argv[3]);
-        }
-    }
-
-    else if (strcmp(argv[2], "getlength") == 0 || strcmp(argv[2], "/ll") == 0) {
-        // get the length of the entire list
-        int le = length(head);
-        // if the length is 0, the list is empty
-        if (le == 0) {
-            exitcode = 2;
-        }
-        else {
-            exitcode = 0;
-        }
-        // if we are not verbose simply print the length
-        if (!verbose) {
-            printf("%i\n", le);
-        }
-        // else print the length of the list in elements and in bytes
-        else {
-            printf("%i elements, %i bytes\n", le, le * sizeof(struct node));
-        }
-    }
-
-    else if (strcmp(argv[2], "sizeof") == 0 || strcmp(argv[2], "/il") == 0) {
-        // get the size of an item in the list
-        // if we do not have a third argument, throw error
-        if (argc < 4) {
-            printf("Missing argument \"sizeof-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        int size = value_length(head, atoi(argv[3]));
-        // if it returns -1 the list is empty
-        if (size == -1) {
-            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 2;
-            goto runaway;
-        }
-        // if it returns -2 the index is out of bounds
-        if (size == -2) {
-            printf("Index %i out of bounds, Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
-            exitcode = 3;
-            goto runaway;
-        }
-        // if we are not verbose simply return the size
-        if (!verbose) {
-            printf("%i\n", size);
-        }
-        // else return the size of the item in bytes
-        else {
-            printf("%i\n%i\n", size, size * 8);
-        }
-    }
-
-    else if (strcmp(argv[2], "new") == 0 || strcmp(argv[2], "/nl") == 0) {
-        // create a new list, the first argument is the file new
-        // if the file exists, overwrite it and clear it
-        // if the file does not exist, create it
-        FILE *fp = fopen(argv[1], "ab+");
-        if (fp == NULL) {
-            printf("Error creating file, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 4;
-            goto runaway;
-        }
-        fclose(fp);
-        // notify if verbose
-        if (verbose) {
-            printf("Created new list file %s\n", argv[1]);
-        }
-
-    }
-
-    // v2 commands after this point //
-
-    else if (strcmp(argv[2], "reverse") == 0 || strcmp(argv[2], "/rv") == 0) {
-       // reverse the list
-       head = reverse(head);
-       // if the head is null the list was empty
-        if (head == NULL) {
-            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 2;
-            goto runaway;
-        }
-        else {
-            exitcode = 0;
-        }
-        // notify if verbose
-        if (verbose) {
-            printf("Reversed list\n");
-        }
-
-
-    }
-
-    else if (strcmp(argv[2], "sort") == 0 || strcmp(argv[2], "/si") == 0) {
-        // if argv[3] is 0 sort by ascending, if 1 sort by descending, else error
-        // if argv[3] is not an integer, error
-        if (argc < 4) {
-            printf("Missing argument \"sort-type-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        if (atoi(argv[3]) == 0) {
-            head = sort(head, 0);
-        }
-        else if (atoi(argv[3]) == 1) {
-            head = sort(head, 1);
-        }
-        else {
-            printf("Invalid sort type argument, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        // if the head is null the list was empty or had a invalid integer
-        if (head == NULL) {
-            printf("Invalid numeric list. Ensure the list contains only integers. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 5;
-            goto runaway;
-        }
-        else {
-            exitcode = 0;
-        }
-        // notify if verbose
-        if (verbose) {
-            printf("Sorted list\n");
-        }
-        goto runaway;
-    }
-
-    // the exact same as sort except with strings
-    else if (strcmp(argv[2], "sortstr") == 0 || strcmp(argv[2], "/ss") == 0) {
-        if (argc < 4) {
-            printf("Missing argument \"sort-type-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        if (atoi(argv[3]) == 0) {
-            head = sortstring(head, 0);
-        }
-        else if (atoi(argv[3]) == 1) {
-            head = sortstring(head, 1);
-        }
-        else {
-            printf("Invalid sort type argument, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        if (head == NULL) {
-            printf("Invalid string list. Ensure the list is populated. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 5;
-            goto runaway;
-        }
-        else {
-            exitcode = 0;
-        }
-        // notify if verbose
-        if (verbose) {
-            // if ascending report
-            if (atoi(argv[3]) == 0) {
-                printf("Sorted list in ascending order\n");
-            }
-            // if descending report
-            else {
-                printf("Sorted list in descending order\n");
-            }
-        }
-        goto runaway;
-    }
-
-
-    else if (strcmp(argv[2], "pushset") == 0 || strcmp(argv[2], "/ps") == 0) {
-        // push multiple values each in different arguments to the list
-        // the second to last argument is 0 or 1 depending if it will be added to the front or back of the list
-        // the last argument is ignored
-        // use argc to determine how many arguments are in the list
-        if (argc < 4) {
-            printf("Missing argument \"pushset-value-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        // if the last argument is not 0 or 1, error
-        if (atoi(argv[argc - 1]) != 0 && atoi(argv[argc - 1]) != 1) {
-            printf("Invalid pushset argument, 0 is front 1 is back. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        // if the last argument is 0, push the values to the front of the list
-        if (atoi(argv[argc - 1]) == 0) {
-            for (int i = 3; i < argc - 1; i++) {
-                push(&head, argv[i]);
-            }
-        }
-        // if the last argument is 1, push the values to the back of the list
-        else if (atoi(argv[argc - 1]) == 1) {
-            for (int i = 3; i < argc - 1; i++) {
-                append(&head, argv[i]);
-            }
-        }
-        goto runaway;
-
-    }
-    // just like pushset but for removing values
-    else if (strcmp(argv[2], "removeset") == 0 || strcmp(argv[2], "/rs") == 0) {
-        // if the value is not found in the list then notify the user of a "miss" and continue to try the remaining values.
-        // if the value is found in the list then remove it and notify the user of a "hit" (only if they are in verbose)
-        // if the list is empty error
-        // last argument is ignored
-        if (argc < 4) {
-            printf("Missing argument \"remove-value-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
-            exitcode = 1;
-            goto runaway;
-        }
-        // for every value in the list
-        for (int i = 3; i < argc; i++) {
-            
-            // if the value is found in the list
-            if (rem_value(&head, argv[i]) != NULL) {
-                // notify the user of a "hit"
-                if (verbose) {
-                    printf("Removed value %s\n", argv[i]);
-                }
-            }
-            // if the value is not found in the list
-            else {
-                // notify the user of a "miss"
-                printf("Value %s not found\n", argv[i]);
-            }
-        }
-
-    }
-
-    else {
-        printf("Unknown command \"%s\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[2], argv[0]);
-        exitcode = 5;
-        goto runaway;
-    }
-    runaway:
-    // write the list to the file
-    export_list(head, argv[1]);
-    exit(exitcode);
-
+// List Plugin
+// By Zeek Halkyr
+// 2/5/22
+
+#include "listlib.h"
+#include "listblk.h"
+#include "listext.h"
+#include "listidx.h"
+#include "listmap.h"
+#include "listsrv.h"
+#include "listwait.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// developer notes:
+// the runaway label is used to break out of the loop and quickly close the file and exit.
+// only the changes are written back at runaway, see save_list.
+// if the list file does not exist, the program will exit with an error. I have added a flag called "/nl" to create a new list, but referencing any file with the format works.
+
+// set when the stats report was asked for with --stats or the LIST_STATS environment variable
+int stats = 0;
+// the command the stats report is about
+char *stats_command = "";
+
+// start timing a phase of the command when the stats report was asked for
+void phase(int which) {
+    if (stats) {
+        stats_phase(which);
+    }
+}
+
+// print the stats report on stderr as the program exits, every exit path gets it this way
+void report_stats(void) {
+    stats_phase(STAT_NONE);
+    stats_print(stderr, stats_command);
+}
+
+// read the range of a print command, argv[3] is the first index and argv[4] the last, a trailing /v is not part of it
+// without a last index the range runs to the end of the list
+// returns 1 if the command has a range and 0 if it prints the whole list
+int read_range(int argc, char** argv, int *from, int *to) {
+    if (strcmp(argv[argc-1], "/v") == 0) {
+        argc--;
+    }
+    if (argc < 4) {
+        return 0;
+    }
+    *from = atoi(argv[3]);
+    *to = argc > 4 ? atoi(argv[4]) : INT_MAX;
+    return 1;
+}
+
+// report a print range that does not fit the list, l is the code print_range returned
+// returns the exit code
+int range_error(int l, int from, int to, char** argv) {
+    if (l == -1) {
+        printf("Range %i to %i out of bounds (EMPTY_LIST), Usage: %s <file> [ <command> <args> ] [/v]\n", from, to, argv[0]);
+        return 2;
+    }
+    if (l == -2) {
+        printf("Range %i to %i out of bounds (NEGATIVE_INDEX), Usage: %s <file> [ <command> <args> ] [/v]\n", from, to, argv[0]);
+        return 3;
+    }
+    printf("Range %i to %i out of bounds (TOO_BIG - remember the list is zero-indexed), Usage: %s <file> [ <command> <args> ] [/v]\n", from, to, argv[0]);
+    return 3;
+}
+
+// report an index of a get command that does not fit the list, l is the code map_item or block_item returned
+// returns the exit code
+int index_error(int l, int index, char** argv) {
+    if (l == -1) {
+        printf("Index %i out of bounds (EMPTY_LIST), Usage: %s <file> [ <command> <args> ] [/v]\n", index, argv[0]);
+        return 2;
+    }
+    if (l == -2) {
+        printf("Index %i out of bounds (NEGATIVE_INDEX), Usage: %s <file> [ <command> <args> ] [/v]\n", index, argv[0]);
+        return 3;
+    }
+    printf("Index %i out of bounds (TOO_BIG - remember the list is zero-indexed), Usage: %s <file> [ <command> <args> ] [/v]\n", index, argv[0]);
+    return 3;
+}
+
+// answer a read-only command from a block list, get and sizeof decompress only the block holding their item
+// and getlength only reads the header. called by mapped_command for a file it could not map
+// returns -1 if the file is not a block list, the caller then loads the list as usual
+int block_command(int argc, char** argv, int verbose, unsigned char *exitcode) {
+    char *command = argv[2];
+    block_list blocks;
+    int opened = block_open(argv[1], &blocks);
+    if (opened > 0) {
+        return -1;
+    }
+    phase(STAT_OPERATION);
+    *exitcode = 0;
+    // l is -5 once a block turns out damaged
+    int l = 0;
+    if (opened < 0) {
+        l = -5;
+    }
+
+    else if (strcmp(command, "get") == 0 || strcmp(command, "/gi") == 0) {
+        // get a specific index in the list and print it
+        if (argc < 4) {
+            printf("Missing argument \"get-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 1;
+        }
+        else {
+            char *item;
+            size_t len;
+            l = block_item(&blocks, atoi(argv[3]), &item, &len);
+            if (l == 0) {
+                fwrite(item, 1, len, stdout);
+                putchar('\n');
+            }
+            else if (l != -5) {
+                *exitcode = index_error(l, atoi(argv[3]), argv);
+            }
+        }
+    }
+
+    else if (strcmp(command, "print") == 0 || strcmp(command, "/gl") == 0) {
+        int from = 0;
+        int to = INT_MAX;
+        // print the entire list to the screen
+        if (!read_range(argc, argv, &from, &to) && blocks.header.count == 0) {
+            printf("Empty list.\n");
+        }
+        // else print the items from the first index to the last, decompressing only the blocks they are in
+        else {
+            l = block_print(&blocks, from, to);
+            if (l != 0 && l != -5) {
+                *exitcode = range_error(l, from, to, argv);
+            }
+        }
+    }
+
+    else if (strcmp(command, "find") == 0 || strcmp(command, "/fv") == 0) {
+        // find a value, the third argument is the value to find
+        if (argc < 4) {
+            printf("Missing argument \"find-value-string\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 1;
+        }
+        else {
+            int index = block_index_of(&blocks, argv[3]);
+            // if the index is -1, the value is not in the list
+            if (index == -5) {
+                l = -5;
+            }
+            else if (index == -1) {
+                printf("Value \"%s\" not in list.\n", argv[3]);
+                *exitcode = 2;
+            }
+            else if (!verbose) {
+                printf("%i\n", index);
+            }
+            else {
+                printf("%i: %s\n", index, argv[3]);
+            }
+        }
+    }
+
+    else if (strcmp(command, "getlength") == 0 || strcmp(command, "/ll") == 0) {
+        // the header holds the number of items
+        int le = (int) blocks.header.count;
+        // if the length is 0, the list is empty
+        if (le == 0) {
+            *exitcode = 2;
+        }
+        if (!verbose) {
+            printf("%i\n", le);
+        }
+        // else print the length of the list in elements and in bytes of list data
+        else {
+            printf("%i elements, %lu bytes\n", le, (unsigned long) block_bytes(&blocks));
+        }
+    }
+
+    else {
+        // get the size of an item in the list
+        if (argc < 4) {
+            printf("Missing argument \"sizeof-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 1;
+        }
+        else {
+            char *item;
+            size_t len;
+            l = block_item(&blocks, atoi(argv[3]), &item, &len);
+            if (l == -1) {
+                printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+                *exitcode = 2;
+            }
+            else if (l == -2 || l == -3) {
+                printf("Index %i out of bounds, Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+                *exitcode = 3;
+            }
+            else if (l == 0 && !verbose) {
+                printf("%i\n", (int) len);
+            }
+            else if (l == 0) {
+                printf("%i\n%i\n", (int) len, (int) len * 8);
+            }
+        }
+    }
+
+    if (l == -5) {
+        printf("Error: file %s could not be read, a binary or block list may be damaged.\n", argv[1]);
+        *exitcode = 4;
+    }
+    block_close(&blocks);
+    return 0;
+}
+
+// answer a read-only command (print, get, find, getlength, sizeof) straight from the mapped list file
+// no list is built and nothing is written back, the exit code is stored in exitcode
+// returns -1 if the command is not read-only or the file could not be mapped, the caller then loads the list as usual
+int mapped_command(int argc, char** argv, int verbose, unsigned char *exitcode) {
+    char *command = argv[2];
+    if (strcmp(command, "print") != 0 && strcmp(command, "/gl") != 0 &&
+        strcmp(command, "get") != 0 && strcmp(command, "/gi") != 0 &&
+        strcmp(command, "find") != 0 && strcmp(command, "/fv") != 0 &&
+        strcmp(command, "getlength") != 0 && strcmp(command, "/ll") != 0 &&
+        strcmp(command, "sizeof") != 0 && strcmp(command, "/il") != 0) {
+        return -1;
+    }
+    // a block list cannot be mapped, it is read a block at a time instead
+    list_map map;
+    if (map_list(argv[1], &map) != 0) {
+        return block_command(argc, argv, verbose, exitcode);
+    }
+    // mapping the file is all the reading a mapped command does, the scans it makes are the command itself
+    phase(STAT_OPERATION);
+    *exitcode = 0;
+
+    if (strcmp(command, "get") == 0 || strcmp(command, "/gi") == 0) {
+        // get a specific index in the list and print it
+        if (argc < 4) {
+            printf("Missing argument \"get-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 1;
+        }
+        else {
+            char *item;
+            size_t len;
+            // a big list is read through its line index, a small one is scanned
+            int l = index_item(argv[1], &map, atoi(argv[3]), &item, &len);
+            if (l == -4) {
+                l = map_item(&map, atoi(argv[3]), &item, &len);
+            }
+            if (l == 0) {
+                fwrite(item, 1, len, stdout);
+                putchar('\n');
+            }
+            else {
+                *exitcode = index_error(l, atoi(argv[3]), argv);
+            }
+        }
+    }
+
+    else if (strcmp(command, "print") == 0 || strcmp(command, "/gl") == 0) {
+        int from;
+        int to;
+        // print the entire list to the screen
+        if (!read_range(argc, argv, &from, &to)) {
+            map_print(&map);
+        }
+        // else print the items from the first index to the last, found through the line index like get
+        else {
+            char *start;
+            char *end;
+            size_t len;
+            int l = index_item(argv[1], &map, from, &start, &len);
+            if (l == -4) {
+                l = map_item(&map, from, &start, &len);
+            }
+            // a backwards range is too big at its start, like in print_range
+            if (l == 0 && from > to) {
+                l = -3;
+            }
+            if (l == 0) {
+                // the range ends where the item after the last one starts, or at the end of the list
+                int next = to < INT_MAX ? to + 1 : to;
+                int found = index_item(argv[1], &map, next, &end, &len);
+                if (found == -4) {
+                    found = map_item(&map, next, &end, &len);
+                }
+                if (found != 0 || next == to) {
+                    end = map.data + map.size;
+                }
+                map_write(&map, start, end);
+            }
+            else {
+                *exitcode = range_error(l, from, to, argv);
+            }
+        }
+    }
+
+    else if (strcmp(command, "find") == 0 || strcmp(command, "/fv") == 0) {
+        // find a value, the third argument is the value to find
+        if (argc < 4) {
+            printf("Missing argument \"find-value-string\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 1;
+        }
+        else {
+            // a big list is searched through its value index, a small one is scanned
+            int index = index_find(argv[1], &map, argv[3]);
+            if (index == -4) {
+                index = map_index_of(&map, argv[3]);
+            }
+            // if the index is -1, the value is not in the list
+            if (index == -1) {
+                printf("Value \"%s\" not in list.\n", argv[3]);
+                *exitcode = 2;
+            }
+            else if (!verbose) {
+                printf("%i\n", index);
+            }
+            else {
+                printf("%i: %s\n", index, argv[3]);
+            }
+        }
+    }
+
+    else if (strcmp(command, "getlength") == 0 || strcmp(command, "/ll") == 0) {
+        // count the items in the file, an up to date line index already knows
+        int le = index_length(argv[1], &map);
+        if (le < 0) {
+            le = map_length(&map);
+        }
+        // if the length is 0, the list is empty
+        if (le == 0) {
+            *exitcode = 2;
+        }
+        if (!verbose) {
+            printf("%i\n", le);
+        }
+        // else print the length of the list in elements and in bytes of list data
+        else {
+            printf("%i elements, %lu bytes\n", le, (unsigned long) map.size);
+        }
+    }
+
+    else {
+        // get the size of an item in the list
+        if (argc < 4) {
+            printf("Missing argument \"sizeof-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 1;
+        }
+        else {
+            char *item;
+            size_t len;
+            // a big list is read through its line index, a small one is scanned
+            int l = index_item(argv[1], &map, atoi(argv[3]), &item, &len);
+            if (l == -4) {
+                l = map_item(&map, atoi(argv[3]), &item, &len);
+            }
+            if (l == -1) {
+                printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+                *exitcode = 2;
+            }
+            else if (l != 0) {
+                printf("Index %i out of bounds, Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+                *exitcode = 3;
+            }
+            else if (!verbose) {
+                printf("%i\n", (int) len);
+            }
+            else {
+                printf("%i\n%i\n", (int) len, (int) len * 8);
+            }
+        }
+    }
+
+    unmap_list(&map);
+    return 0;
+}
+
+// push or pop a front-offset list or append to a block list without loading it,
+// only the front of the file or the last block of the block list is touched
+// returns -1 if this is not a command that can be done in place on the list file,
+// the caller then loads the list as usual
+int front_command(int argc, char** argv, int verbose, unsigned char *exitcode) {
+    char *command = argv[2];
+    if ((strcmp(command, "append") == 0 || strcmp(command, "/ab") == 0) && argc >= 4) {
+        int result = block_append(argv[1], argv[3]);
+        if (result == 1) {
+            return -1;
+        }
+        *exitcode = result == 0 ? 0 : 4;
+        // notify if verbose
+        if (result == 0 && verbose) {
+            printf("Appended \"%s\" to the end of the list\n", argv[3]);
+        }
+        return 0;
+    }
+    if ((strcmp(command, "push") == 0 || strcmp(command, "/af") == 0) && argc >= 4) {
+        int result = front_push(argv[1], argv[3]);
+        if (result == 1) {
+            return -1;
+        }
+        *exitcode = result == 0 ? 0 : 4;
+        // notify if verbose
+        if (result == 0 && verbose) {
+            printf("Pushed \"%s\" to the front of the list\n", argv[3]);
+        }
+        return 0;
+    }
+    if (strcmp(command, "pop") == 0 || strcmp(command, "/rf") == 0 || strcmp(command, "waitpop") == 0 || strcmp(command, "/wf") == 0) {
+        char *value;
+        int result = front_pop(argv[1], &value);
+        if (result == 1) {
+            return -1;
+        }
+        if (result == 2) {
+            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 2;
+            return 0;
+        }
+        if (result != 0) {
+            *exitcode = 4;
+            return 0;
+        }
+        *exitcode = 0;
+        // notify if verbose
+        if (verbose) {
+            printf("Popped \"%s\" from the front of the list\n", value);
+        }
+        // else just print the value
+        else {
+            printf("%s\n", value);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+// read the timeout of a waitpop or waitpopback command from argv[3], a trailing /v is not part of it
+// returns the timeout in milliseconds, -1 to wait forever or -2 if the timeout is not a number of seconds
+long wait_timeout(int argc, char** argv) {
+    if (strcmp(argv[argc-1], "/v") == 0) {
+        argc--;
+    }
+    if (argc < 4 || (strcmp(argv[2], "waitpop") != 0 && strcmp(argv[2], "/wf") != 0 &&
+        strcmp(argv[2], "waitpopback") != 0 && strcmp(argv[2], "/wb") != 0)) {
+        return -1;
+    }
+    return read_timeout(argv[3]);
+}
+
+// check the timeout of a command, only waitpop and waitpopback have one
+int valid_timeout(int argc, char** argv) {
+    return wait_timeout(argc, argv) != -2;
+}
+
+// block until the list has an item, then pop it from the front for waitpop or from the end for waitpopback
+// the list is checked and popped under the writer lock and the lock is released while waiting,
+// so every item goes to exactly one of the commands waiting for it
+// returns -1 if the command is not a wait or its timeout is not valid, run_command then reports it
+int wait_command(int argc, char** argv, int verbose, unsigned char *exitcode) {
+    char *command = argv[2];
+    if (strcmp(command, "waitpop") != 0 && strcmp(command, "/wf") != 0 &&
+        strcmp(command, "waitpopback") != 0 && strcmp(command, "/wb") != 0) {
+        return -1;
+    }
+    long timeout = wait_timeout(argc, argv);
+    if (timeout == -2) {
+        return -1;
+    }
+    long long deadline = clock_ms() + timeout;
+    // the watch is only set up once the list turned out to be empty and the list is checked once more after that,
+    // so an item that arrives between a check and the wait still wakes us. a list that has an item never pays for it
+    list_watch watch;
+    int watching = 0;
+    for (;;) {
+        // without the lock two waiters could pop the same item, so a lock that cannot be taken is an error
+        list_lock lock;
+        if (lock_list(argv[1], &lock) != 0) {
+            printf("Error: could not lock list file %s.\n", argv[1]);
+            *exitcode = 4;
+            if (watching) {
+                unwatch_list(&watch);
+            }
+            return 0;
+        }
+        // an empty list is spotted from its size without loading it
+        list_map map;
+        int empty = 0;
+        if (map_list(argv[1], &map) == 0) {
+            empty = map.size == 0;
+            unmap_list(&map);
+        }
+        // a block list keeps its count in its header
+        else {
+            empty = block_count(argv[1]) == 0;
+        }
+        if (!empty) {
+            // a front-offset list pops its first item without loading the list
+            if (front_command(argc, argv, verbose, exitcode) != 0) {
+                list_t *list = create_list(argv[1]);
+                if (list == NULL) {
+                    printf("Error: file %s does not exist.\n", argv[1]);
+                    *exitcode = 1;
+                }
+                else {
+                    *exitcode = run_command(list, argc, argv);
+                    if (*exitcode == 0 && save_list(list, argv[1]) != 0) {
+                        *exitcode = 4;
+                    }
+                    free_list(list);
+                }
+            }
+            unlock_list(&lock);
+            // hand the item over before the watch goes, closing it can take the kernel a few milliseconds
+            fflush(stdout);
+            if (watching) {
+                unwatch_list(&watch);
+            }
+            return 0;
+        }
+        unlock_list(&lock);
+        if (!watching) {
+            watch_list(argv[1], &watch);
+            watching = 1;
+            continue;
+        }
+        // give up once the timeout has passed
+        long left = timeout < 0 ? -1 : (long) (deadline - clock_ms());
+        if (timeout >= 0 && left <= 0) {
+            printf("List is empty, timed out waiting for an item, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            *exitcode = 2;
+            unwatch_list(&watch);
+            return 0;
+        }
+        wait_change(&watch, left);
+    }
+}
+
+// read the order of a sortlex command, argv[3] holds the modes separated by commas, argv[4] the direction
+// and argv[5] may say "stable". the first mode is the primary key and the rest break its ties
+// returns 0 on success, -1 if a mode is not valid and -2 if the direction is not 0 or 1
+int read_order(int argc, char** argv, lex_order *order) {
+    order->keys = 0;
+    order->ascending = strcmp(argv[4], "0") == 0;
+    order->stable = argc > 5 && strcmp(argv[5], "stable") == 0;
+    char modes[256];
+    strncpy(modes, argv[3], sizeof(modes) - 1);
+    modes[sizeof(modes) - 1] = '\0';
+    for (char *mode = strtok(modes, ","); mode != NULL; mode = strtok(NULL, ",")) {
+        int parsed = lex_mode(mode);
+        if (parsed < 0 || order->keys == LEX_KEYS) {
+            return -1;
+        }
+        order->modes[order->keys++] = parsed;
+    }
+    if (order->keys == 0) {
+        return -1;
+    }
+    if (strcmp(argv[4], "0") != 0 && strcmp(argv[4], "1") != 0) {
+        return -2;
+    }
+    return 0;
+}
+
+// run a sort command on a list file bigger than the memory budget, see external_sort
+// returns -1 if the command is not a sort or its arguments are not valid, run_command then handles it as usual
+int external_command(int argc, char** argv, int verbose, size_t limit, unsigned char *exitcode) {
+    char *command = argv[2];
+    lex_order order;
+    int numbers = 0;
+    if ((strcmp(command, "sort") == 0 || strcmp(command, "/si") == 0) && argc >= 4 &&
+        (strcmp(argv[3], "0") == 0 || strcmp(argv[3], "1") == 0)) {
+        numbers = 1;
+        order.ascending = strcmp(argv[3], "0") == 0;
+    }
+    else if ((strcmp(command, "sortstr") == 0 || strcmp(command, "/ss") == 0) && argc >= 4 &&
+             (strcmp(argv[3], "0") == 0 || strcmp(argv[3], "1") == 0)) {
+        order.modes[0] = LEX_LENGTH;
+        order.keys = 1;
+        order.ascending = strcmp(argv[3], "0") == 0;
+        order.stable = 1;
+    }
+    else if ((strcmp(command, "sortlex") == 0 || strcmp(command, "/sl") == 0) && argc >= 5) {
+        if (read_order(argc, argv, &order) != 0) {
+            return -1;
+        }
+    }
+    else {
+        return -1;
+    }
+    int result = external_sort(argv[1], numbers, &order, limit);
+    // an empty list gets the usual error from run_command, a binary list is sorted by it in memory
+    if (result == 1) {
+        return -1;
+    }
+    if (result == -2) {
+        printf("Invalid numeric list. Ensure the list contains only integers. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+        *exitcode = 5;
+        return 0;
+    }
+    if (result != 0) {
+        printf("Error: could not sort %s through temporary files.\n", argv[1]);
+        *exitcode = 4;
+        return 0;
+    }
+    *exitcode = 0;
+    // notify if verbose
+    if (verbose) {
+        printf("Sorted list\n");
+    }
+    return 0;
+}
+
+// run one command against a loaded list
+// argv is laid out like the program's own arguments: argv[1] is the list file and argv[2] the command
+// returns the exit code of the command, the caller writes the list back
+int run_command(list_t *list, int argc, char** argv) {
+    unsigned char exitcode = 0;
+    // if the last argument (argv[argc-1]) is "/v", set the verbose flag to true
+    int verbose = 0;
+    if (strcmp(argv[argc-1], "/v") == 0 || strcmp(argv[2], "new") == 0) {
+        verbose = 1;
+    }
+    // switch on the command (the second argument)
+    if (strcmp(argv[2], "push") == 0 || strcmp(argv[2], "/af") == 0) {
+        // push the third argument to the front of the list
+        // if we dont have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"push-item\", Usage: %s <file> [ <command> <args> ]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        push(list, argv[3]);
+        // notify if verbose
+        if (verbose) {
+            printf("Pushed \"%s\" to the front of the list\n", argv[3]);
+        }
+        
+    }
+
+    else if (strcmp(argv[2], "pop") == 0 || strcmp(argv[2], "/rf") == 0 || strcmp(argv[2], "waitpop") == 0 || strcmp(argv[2], "/wf") == 0) {
+        // waitpop pops right away once it gets here, the waiting is done by wait_command and the list server
+        if (!valid_timeout(argc, argv)) {
+            printf("Invalid argument \"timeout-seconds\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // pop the first node from the list
+        char* value = pop(list);
+        // if the value is null, throw error
+        if (value == NULL) {
+            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 2;
+            return exitcode;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Popped \"%s\" from the front of the list\n", value);
+        }
+        // else just print the value
+        else {
+            printf("%s\n", value);
+        }
+    }
+
+    else if (strcmp(argv[2], "append") == 0 || strcmp(argv[2], "/ab") == 0) {
+        // append an item to the end of the list
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"append-item\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        append(list, argv[3]);
+        // notify if verbose
+        if (verbose) {
+            printf("Appended \"%s\" to the end of the list\n", argv[3]);
+        }
+
+    }
+
+    else if (strcmp(argv[2], "popback") == 0 || strcmp(argv[2], "/rb") == 0 || strcmp(argv[2], "waitpopback") == 0 || strcmp(argv[2], "/wb") == 0) {
+        // waitpopback pops right away once it gets here, like waitpop
+        if (!valid_timeout(argc, argv)) {
+            printf("Invalid argument \"timeout-seconds\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // popback an item from the end of the list
+        char* value = pop_end(list);
+        // if the value is null, throw error
+        if (value == NULL) {
+            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Popped \"%s\" from the end of the list\n", value);
+        }
+        // else just print the value
+        else {
+            printf("%s\n", value);
+        }
+    }
+
+    else if (strcmp(argv[2], "remove") == 0 || strcmp(argv[2], "/ra") == 0) {
+        // remove an item from the list at the index in argument 3
+        // behavior is undefined for a alphanumeric passed
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"remove-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        char* value = rem_index(list, atoi(argv[3]));
+        // if the value is null it is out of bounds
+        if (value == NULL) {
+            printf("Index %i out of bounds, Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+            exitcode = 3;
+            return exitcode;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Removed \"%s\" from the list at index %i\n", value, atoi(argv[3]));
+        }
+        // else
+        else {
+            printf("%s\n", value);
+        }
+    }
+
+    else if (strcmp(argv[2], "removewhere") == 0 || strcmp(argv[2], "/rw") == 0) {
+        // remove an item from the list where the value is the third argument
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"remove-value-string\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        char* value = rem_value(list, argv[3]);
+        // if the value is null it is not in the list or the list is empty
+        if (value == NULL) {
+            printf("Value \"%s\" not in list.\n", argv[3], argv[0]);
+            exitcode = 2;
+            return exitcode;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Removed \"%s\" from the list at %i\n", value, atoi(argv[3]));
+        }
+        // else
+        else {
+            printf("%s\n", value);
+        }
+    }
+
+    else if (strcmp(argv[2], "get") == 0 || strcmp(argv[2], "/gi") == 0) {
+        // get a specific index in the list and print it
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"get-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;      
+            return exitcode;
+        }
+        int l = print_index(list, atoi(argv[3]));
+        if (l == -1) {
+            printf("Index %i out of bounds (EMPTY_LIST), Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+            exitcode = 2;
+            return exitcode;
+        }
+        if (l == -2) {
+            printf("Index %i out of bounds (NEGATIVE_INDEX), Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+            exitcode = 3;
+            return exitcode;
+        }
+        if (l == -3) {
+            printf("Index %i out of bounds (TOO_BIG - remember the list is zero-indexed), Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+            exitcode = 3;
+            return exitcode;
+        }
+
+    }
+
+    else if (strcmp(argv[2], "print") == 0 || strcmp(argv[2], "/gl") == 0) {
+        int from;
+        int to;
+        // print the entire list to the screen
+        if (!read_range(argc, argv, &from, &to)) {
+            print_list(list);
+        }
+        // else print the items from the first index to the last
+        else {
+            int l = print_range(list, from, to);
+            if (l != 0) {
+                exitcode = range_error(l, from, to, argv);
+                return exitcode;
+            }
+        }
+    }
+
+    else if (strcmp(argv[2], "insert") == 0 || strcmp(argv[2], "/ia") == 0) {
+        // insert the item at argument 4 at the index in argument 3
+        // if argument 3 is not an integer, behavior is undefined
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"insert-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // if we do not have a fourth argument, throw error
+        if (argc < 5) {
+            printf("Missing argument \"insert-item\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // an index past the end is reported, a negative one is ignored
+        if (insert_index(list, atoi(argv[3]), argv[4]) == -3) {
+            printf("Could not insert at index %d\n", atoi(argv[3]));
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Inserted \"%s\" at index %i\n", argv[4], atoi(argv[3]));
+        }
+    }
+
+    else if (strcmp(argv[2], "find") == 0 || strcmp(argv[2], "/fv") == 0) {
+        // find a value using index_of, the third argument is the value to find
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"find-value-string\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        int index = index_of(list, argv[3]);
+        // if the index is -1, the value is not in the list
+        if (index == -1) {
+            printf("Value \"%s\" not in list.\n", argv[3], argv[0]);    
+            exitcode = 2;
+            return exitcode;
+        }
+        // if we are not verbose simply print the index
+        if (!verbose) {
+            printf("%i\n", index);
+        }
+        // else print the index and the value
+        else {
+            printf("%i: %s\n", index, argv[3]);
+        }
+    }
+
+    else if (strcmp(argv[2], "getlength") == 0 || strcmp(argv[2], "/ll") == 0) {
+        // get the length of the entire list
+        int le = length(list);
+        // if the length is 0, the list is empty
+        if (le == 0) {
+            exitcode = 2;
+        }
+        else {
+            exitcode = 0;
+        }
+        // if we are not verbose simply print the length
+        if (!verbose) {
+            printf("%i\n", le);
+        }
+        // else print the length of the list in elements and the memory it takes up
+        else {
+            printf("%i elements, %zu bytes\n", le, list_memory(list));
+        }
+    }
+
+    else if (strcmp(argv[2], "sizeof") == 0 || strcmp(argv[2], "/il") == 0) {
+        // get the size of an item in the list
+        // if we do not have a third argument, throw error
+        if (argc < 4) {
+            printf("Missing argument \"sizeof-index-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        int size = value_length(list, atoi(argv[3]));
+        // if it returns -1 the list is empty
+        if (size == -1) {
+            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 2;
+            return exitcode;
+        }
+        // if it returns -2 the index is out of bounds
+        if (size == -2) {
+            printf("Index %i out of bounds, Usage: %s <file> [ <command> <args> ] [/v]\n", atoi(argv[3]), argv[0]);
+            exitcode = 3;
+            return exitcode;
+        }
+        // if we are not verbose simply return the size
+        if (!verbose) {
+            printf("%i\n", size);
+        }
+        // else return the size of the item in bytes
+        else {
+            printf("%i\n%i\n", size, size * 8);
+        }
+    }
+
+    else if (strcmp(argv[2], "new") == 0 || strcmp(argv[2], "/nl") == 0) {
+        // create a new list, the first argument is the file new
+        // if the file exists, overwrite it and clear it
+        // if the file does not exist, create it
+        FILE *fp = fopen(argv[1], "ab+");
+        if (fp == NULL) {
+            printf("Error creating file, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 4;
+            return exitcode;
+        }
+        fclose(fp);
+        // notify if verbose
+        if (verbose) {
+            printf("Created new list file %s\n", argv[1]);
+        }
+
+    }
+
+    // v2 commands after this point //
+
+    else if (strcmp(argv[2], "reverse") == 0 || strcmp(argv[2], "/rv") == 0) {
+       // reverse the list
+       // if reverse fails the list was empty
+        if (reverse(list) != 0) {
+            printf("List is empty, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 2;
+            return exitcode;
+        }
+        else {
+            exitcode = 0;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Reversed list\n");
+        }
+
+
+    }
+
+    else if (strcmp(argv[2], "sort") == 0 || strcmp(argv[2], "/si") == 0) {
+        // if argv[3] is 0 sort by ascending, if 1 sort by descending, else error
+        // if argv[3] is not an integer, error
+        if (argc < 4) {
+            printf("Missing argument \"sort-type-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        if (atoi(argv[3]) == 0) {
+            exitcode = sort(list, 1);
+        }
+        else if (atoi(argv[3]) == 1) {
+            exitcode = sort(list, 0);
+        }
+        else {
+            printf("Invalid sort type argument, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // if the sort failed the list was empty or had a invalid integer
+        if (exitcode != 0) {
+            printf("Invalid numeric list. Ensure the list contains only integers. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 5;
+            return exitcode;
+        }
+        else {
+            exitcode = 0;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Sorted list\n");
+        }
+        return exitcode;
+    }
+
+    // the exact same as sort except with strings
+    else if (strcmp(argv[2], "sortlex") == 0 || strcmp(argv[2], "/sl") == 0) {
+        // sort by one or more string orders, the third argument lists them separated by commas,
+        // the fourth is 0 for ascending and 1 for descending and "stable" after that keeps ties in their order
+        if (argc < 5) {
+            printf("Missing argument \"sort-mode\" or \"sort-type-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        lex_order order;
+        int parsed = read_order(argc, argv, &order);
+        if (parsed == -1) {
+            printf("Invalid sort mode \"%s\", use up to %i of byte, nocase, natural or length separated by commas. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[3], LEX_KEYS, argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        if (parsed == -2) {
+            printf("Invalid sort type argument, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        if (sortlex(list, &order) != 0) {
+            printf("Invalid string list. Ensure the list is populated. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 5;
+            return exitcode;
+        }
+        // notify if verbose
+        if (verbose) {
+            printf("Sorted list by %s in %s order\n", argv[3], order.ascending ? "ascending" : "descending");
+        }
+        return exitcode;
+    }
+
+    else if (strcmp(argv[2], "sortstr") == 0 || strcmp(argv[2], "/ss") == 0) {
+        if (argc < 4) {
+            printf("Missing argument \"sort-type-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        if (atoi(argv[3]) == 0) {
+            exitcode = sortstring(list, 1);
+        }
+        else if (atoi(argv[3]) == 1) {
+            exitcode = sortstring(list, 0);
+        }
+        else {
+            printf("Invalid sort type argument, Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        if (exitcode != 0) {
+            printf("Invalid string list. Ensure the list is populated. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 5;
+            return exitcode;
+        }
+        else {
+            exitcode = 0;
+        }
+        // notify if verbose
+        if (verbose) {
+            // if ascending report
+            if (atoi(argv[3]) == 0) {
+                printf("Sorted list in ascending order\n");
+            }
+            // if descending report
+            else {
+                printf("Sorted list in descending order\n");
+            }
+        }
+        return exitcode;
+    }
+
+
+    else if (strcmp(argv[2], "pushset") == 0 || strcmp(argv[2], "/ps") == 0) {
+        // push multiple values each in different arguments to the list
+        // the second to last argument is 0 or 1 depending if it will be added to the front or back of the list
+        // the last argument is ignored
+        // use argc to determine how many arguments are in the list
+        if (argc < 4) {
+            printf("Missing argument \"pushset-value-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // if the last argument is not 0 or 1, error
+        if (atoi(argv[argc - 1]) != 0 && atoi(argv[argc - 1]) != 1) {
+            printf("Invalid pushset argument, 0 is front 1 is back. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // if the last argument is 0, push the values to the front of the list
+        if (atoi(argv[argc - 1]) == 0) {
+            for (int i = 3; i < argc - 1; i++) {
+                push(list, argv[i]);
+            }
+        }
+        // if the last argument is 1, push the values to the back of the list
+        else if (atoi(argv[argc - 1]) == 1) {
+            for (int i = 3; i < argc - 1; i++) {
+                append(list, argv[i]);
+            }
+        }
+        return exitcode;
+
+    }
+    // just like pushset but for removing values
+    else if (strcmp(argv[2], "removeset") == 0 || strcmp(argv[2], "/rs") == 0) {
+        // if the value is not found in the list then notify the user of a "miss" and continue to try the remaining values.
+        // if the value is found in the list then remove it and notify the user of a "hit" (only if they are in verbose)
+        // if the list is empty error
+        // last argument is ignored
+        if (argc < 4) {
+            printf("Missing argument \"remove-value-#\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        // remove every value in one pass over the list
+        int *found = malloc(sizeof(int) * argc);
+        rem_values(list, argv + 3, argc - 3, found);
+        for (int i = 3; i < argc; i++) {
+            
+            // if the value is found in the list
+            if (found[i - 3]) {
+                // notify the user of a "hit"
+                if (verbose) {
+                    printf("Removed value %s\n", argv[i]);
+                }
+            }
+            // if the value is not found in the list
+            else {
+                // notify the user of a "miss"
+                printf("Value %s not found\n", argv[i]);
+            }
+        }
+        free(found);
+
+    }
+
+    else if (strcmp(argv[2], "convert") == 0 || strcmp(argv[2], "/cv") == 0) {
+        // rewrite the list file in another format, the items stay the same
+        if (argc < 4) {
+            printf("Missing argument \"format\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        if (strcmp(argv[3], "plain") == 0) {
+            list->format = FORMAT_PLAIN;
+        }
+        else if (strcmp(argv[3], "front") == 0) {
+            list->format = FORMAT_FRONT;
+        }
+        else if (strcmp(argv[3], "binary") == 0) {
+            list->format = FORMAT_BINARY;
+        }
+        else if (strcmp(argv[3], "blocks") == 0) {
+            list->format = FORMAT_BLOCKS;
+        }
+        else {
+            printf("Invalid format \"%s\", use plain, front, binary or blocks. Usage: %s <file> [ <command> <args> ] [/v]\n", argv[3], argv[0]);
+            exitcode = 1;
+            return exitcode;
+        }
+        list->dirty = 1;
+        // notify if verbose
+        if (verbose) {
+            printf("Converted list to %s format\n", argv[3]);
+        }
+    }
+
+    else {
+        printf("Unknown command \"%s\", Usage: %s <file> [ <command> <args> ] [/v]\n", argv[2], argv[0]);
+        exitcode = 5;
+        return exitcode;
+    }
+    return exitcode;
+}
+
+// read one line of any length from a file, without its newline
+// returns null at the end of the file
+char* read_line(FILE *file) {
+    int capacity = 256;
+    int len = 0;
+    char *line = malloc(capacity);
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n') {
+        if (len + 1 == capacity) {
+            capacity *= 2;
+            line = realloc(line, capacity);
+        }
+        line[len++] = c;
+    }
+    if (c == EOF && len == 0) {
+        free(line);
+        return NULL;
+    }
+    // drop the carriage return of a CRLF line ending
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    line[len] = '\0';
+    return line;
+}
+
+// split a script line into arguments in place, the same way the shell would for a command line
+// arguments are separated by spaces or tabs and "" quotations keep spaces inside an argument
+// the arguments are added to args from index count, the new count is returned
+int split_args(char *line, char ***args, int count, int *capacity) {
+    char *c = line;
+    while (*c != '\0') {
+        // skip the separators
+        while (*c == ' ' || *c == '\t') {
+            c++;
+        }
+        if (*c == '\0') {
+            break;
+        }
+        // a comment runs to the end of the line
+        if (*c == '#' && count == 2) {
+            break;
+        }
+        char *arg = c;
+        // a quoted argument runs to the closing quote
+        if (*c == '"') {
+            arg = ++c;
+            while (*c != '\0' && *c != '"') {
+                c++;
+            }
+        }
+        else {
+            while (*c != '\0' && *c != ' ' && *c != '\t') {
+                c++;
+            }
+        }
+        if (*c != '\0') {
+            *c++ = '\0';
+        }
+        if (count == *capacity) {
+            *capacity *= 2;
+            *args = realloc(*args, sizeof(char*) * *capacity);
+        }
+        (*args)[count++] = arg;
+    }
+    return count;
+}
+
+// run a script of commands against one loaded list
+// each line of the script is one command and its arguments, blank lines and lines starting with # are skipped
+// the list is loaded once, every command runs in order and the changes are written back once at the end
+// the exit code of every command is reported on stderr in order, the script exits with the last failing code
+int run_script(char* program, char* filename, char* scriptname) {
+    FILE *script = strcmp(scriptname, "-") == 0 ? stdin : fopen(scriptname, "r");
+    if (script == NULL) {
+        printf("Error: script %s does not exist.\n", scriptname);
+        return 1;
+    }
+    // hold the writer lock for the whole script, the list stays loaded from its first command to its last
+    list_lock lock;
+    if (lock_list(filename, &lock) != 0) {
+        printf("Error: could not lock list file %s.\n", filename);
+        if (script != stdin) {
+            fclose(script);
+        }
+        return 4;
+    }
+    // create the list, a list file that is there but cannot be read is left alone
+    list_t *list = create_list(filename);
+    if (list == NULL) {
+        FILE *file = fopen(filename, "rb");
+        if (file != NULL) {
+            fclose(file);
+            printf("Error: file %s could not be read, a binary or block list may be damaged.\n", filename);
+            unlock_list(&lock);
+            if (script != stdin) {
+                fclose(script);
+            }
+            return 4;
+        }
+        list = new_list();
+    }
+    unsigned char exitcode = 0;
+    int capacity = 16;
+    char **args = malloc(sizeof(char*) * capacity);
+    int lineno = 0;
+    char *line;
+    while ((line = read_line(script)) != NULL) {
+        lineno++;
+        // every command sees the same program and list file arguments
+        args[0] = program;
+        args[1] = filename;
+        int count = split_args(line, &args, 2, &capacity);
+        if (count > 2) {
+            unsigned char code = run_command(list, count, args);
+            // keep the command's output ahead of its status
+            fflush(stdout);
+            fprintf(stderr, "%i: %s exit %i\n", lineno, args[2], code);
+            if (code != 0) {
+                exitcode = code;
+            }
+        }
+        free(line);
+    }
+    free(args);
+    if (script != stdin) {
+        fclose(script);
+    }
+    // write the changes of every command back in one go
+    if (save_list(list, filename) != 0) {
+        exitcode = 4;
+    }
+    unlock_list(&lock);
+    free_list(list);
+    return exitcode;
+}
+
+int main(int argc, char** argv) {
+    unsigned char exitcode = 0; // will exit with this code
+    // if the first argument is -?, --?, /? or ? then print the help message
+    if (argc == 2 && (strcmp(argv[1], "-?") == 0 || strcmp(argv[1], "--?") == 0 || strcmp(argv[1], "/?") == 0 || strcmp(argv[1], "?") == 0)) {
+        printf("\nlist.exe by Zeek Halkyr - a list program that can be used to manipulate data\n");
+        printf("\n");
+        printf("Usage: list [filename] [option] [arguments] [/v] \n\n");
+        printf("Lists are stored in a text file that is the first argument. The file is expected to exist, you can create a list with the /nl or new flag.\n");
+        printf("The list file will be automatically updated after execution.\n");
+        printf("You can specify any file that has strings separate by newlines. Each line is a separate item in the list.\n");
+        printf("It is recommended to encapsulate strings in quotes.\n\n");
+        printf("Options (batch-style flag | alternative style, parameters are the same): \n");
+        printf("\t/v  | verbose - use as the final argument, extends logging level\n");
+        printf("\t/af | push <value> - push an item to the front of the list\n"); 
+        printf("\t/rf | pop - pop an item from the front of the list and return it\n");
+        printf("\t/ab | append <value> - append an item to the end of the list\n");
+        printf("\t/rb | popback - pop an item from the end of the list and return it\n");
+        printf("\t/wf | waitpop [<seconds>] - wait until the list has an item, then pop it from the front. waits forever without a timeout\n");
+        printf("\t/wb | waitpopback [<seconds>] - wait until the list has an item, then pop it from the end\n");
+        printf("\t/ra | remove <index> - remove an item by index and return it\n");
+        printf("\t/rw | removewhere <value> - remove an item by value, notifies if not found\n");
+        printf("\t/gi | get <index> - print the value stored at an index\n");
+        printf("\t/gl | print [<from> [<to>]] - print the entire list, or the items from index <from> to <to>, each item on a newline\n");
+        printf("\t/ia | insert <index> <value> - insert an item at an index, the previous item at that index is pushed to to the right/down\n");
+        printf("\t/fv | find <value> - find a value and return its index, notifies if not found\n");
+        printf("\t/ll | getlength - get the length of the list in number of elements\n");
+        printf("\t/il | sizeof <index> - get the length of a value in the list. returns both characters and bytes size in verbose mode\n");
+        printf("\t/nl | new <filename> - new list, creates a new list with the specified name\n\n");
+        printf("\t/rs | reverse - reverse the list\n");
+        printf("\t/ps | pushset <space separated items> <0/1> - push any number of items to the list, the final argument is 0 for front 1 for back.\n");
+        printf("\t/rs | removeset <space separated items> <0/1> - remove any number of items from the list, it will report if a item is not found and remove the rest.\n");
+        printf("\t/ss | sortstr <0/1> - sort the list by string length. 0 for ascending 1 for descending. \n");
+        printf("\t/sl | sortlex <mode[,mode]> <0/1> [stable] - sort the list by string order, the modes are byte, nocase, natural (numbers in the text by value) and length. later modes break ties. 0 for ascending 1 for descending, stable keeps tied items in their order.\n");
+        printf("\t/si | sort <0/1> - sort the list by number. 0 for ascending 1 for descending. Non-integer values will throw an error, negative and 64 bit integers are fine. \n");
+        printf("\t/cv | convert <plain/front/binary/blocks> - rewrite the list file in another format. front keeps a gap before the first item so push and pop do not rewrite the file. binary keeps a table of where every item starts so reading any item needs no scan. blocks compresses the items in blocks of a few thousand lines, reading an item decompresses only its block and an append rewrites only the last block.\n");
+        printf("\t--mem-limit <size> - use after a sort command (sort, sortstr, sortlex) to cap its memory, such as 64M or 2G. a bigger list is sorted in pieces through temporary files next to it.\n");
+        printf("\t--stats - use after the command to print what it cost on stderr as one line of JSON: time spent reading the list, running the command and writing it back, bytes read and written, system calls, allocations and peak memory. setting the %s environment variable to 1 does the same.\n", STATS_ENV);
+        printf("\t--script <file or -> - run one command per line of the file (or stdin for -) against the list, which is loaded and written once. the exit code of every command is reported on stderr.\n");
+        printf("\t--serve <socket> [seconds] - run as a list server on a unix domain socket instead (use as the first argument). lists stay in memory and are written back every few seconds (1 by default) and on shutdown.\n");
+        printf("\t                           when the %s environment variable names the socket of a running server, commands are sent to it.\n", SERVER_ENV);
+        printf("Examples: \n");
+        printf("\tlist.exe list.txt /af \"hello\"\n");
+        printf("\tlist.exe list.txt /rf\n");
+        printf("\tlist.exe list.txt /gi 3\n");
+        printf("\tlist.exe list.txt /il 8\n");
+        printf("Exit Codes:\n");
+        printf("\t0 - OK\n");
+        printf("\t1 - ARG_FAILURE (Missing argument or invalid filename)\n");
+        printf("\t2 - EMPTY_LIST (Value not found or the list was empty)\n");
+        printf("\t3 - INDEX_OUT_OF_BOUNDS (Negative integer or too large)\n");
+        printf("\t4 - FILE_ERROR (Couldn't create a new file, general fault)\n");
+        printf("\t5 - NO_COMMAND (Invalid or missing command)\n");
+        printf("Notes:\n");
+        printf("\tThe program will error if the list file does not exist. Use /nl \n");
+        exit(0);
+    }
+    // run as a list server, the second argument is the socket and an optional third the flush interval in seconds
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        if (argc < 3) {
+            printf("Missing argument \"socket\", Usage: %s --serve <socket> [flush-seconds]\n", argv[0]);
+            exit(1);
+        }
+        int interval = argc > 3 ? atoi(argv[3]) : SERVER_FLUSH;
+        exit(serve(argv[0], argv[2], interval > 0 ? interval : SERVER_FLUSH));
+    }
+    // check if we have a list file
+    list_t *list = NULL;
+    if (argc == 2) {
+        // there isn't a command, error
+        printf("Error: no command specified, usage: %s <file> [ <command> <args> ] [/v]\n%s /? for help.", argv[0], argv[0]);
+        exit(1);
+    }
+    // if we have more than two arguments:
+    if (argc > 2) {
+        // if the second argument is /nl we are trying to create a new list, goto escape
+        if (strcmp(argv[2], "/nl") == 0 || strcmp(argv[2], "new") == 0) {
+            goto escape;
+        }
+        // else, if the file doesn't exist, report an error and exit
+        FILE *fp = fopen(argv[1], "r");
+        if (fp == NULL) {
+            printf("Error: file %s does not exist.\n", argv[1]);
+            exit(1);
+        }
+
+    }
+    escape:
+
+    // check that we have at least two arguments
+    if (argc < 3) {
+        printf("Missing argument \"command\", usage: %s <file> [ <command> <args> ] [/v]\n%s /? for help.", argv[0], argv[0]);
+        exitcode = 1;
+        goto runaway;
+    }
+    // --stats anywhere after the command prints what the command cost on stderr as one JSON line,
+    // LIST_STATS=1 does the same without changing the command
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+            // take the option out so the command sees its usual arguments
+            memmove(&argv[i], &argv[i + 1], sizeof(char*) * (argc - i));
+            argc--;
+            break;
+        }
+    }
+    char *stats_env = getenv(STATS_ENV);
+    if (stats_env != NULL && strcmp(stats_env, "1") == 0) {
+        stats = 1;
+    }
+    if (stats) {
+        stats_command = argv[2];
+        atexit(report_stats);
+        // reading the list is the parse phase, the commands that never read the whole list move on from it early
+        phase(STAT_PARSE);
+    }
+    // --mem-limit <size> anywhere after the command caps the memory a sort may use,
+    // a list file bigger than that is sorted through temporary run files
+    size_t mem_limit = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--mem-limit") == 0) {
+            mem_limit = i + 1 < argc ? read_size(argv[i + 1]) : 0;
+            if (mem_limit == 0) {
+                printf("Invalid argument \"memory-limit\", use a size such as 512K, 64M or 2G. Usage: %s <file> [ <command> <args> ] [--mem-limit <size>] [/v]\n", argv[0]);
+                exit(1);
+            }
+            // take the option out so the command sees its usual arguments
+            memmove(&argv[i], &argv[i + 2], sizeof(char*) * (argc - i - 1));
+            argc -= 2;
+            break;
+        }
+    }
+
+    // hand the command to the list server if one is running
+    if (strcmp(argv[2], "--script") != 0 && forward(argc, argv, &exitcode) == 0) {
+        exit(exitcode);
+    }
+
+    // run a script of commands against the list
+    if (strcmp(argv[2], "--script") == 0) {
+        if (argc < 4) {
+            printf("Missing argument \"script-file\", Usage: %s <file> --script <commands-file or ->\n", argv[0]);
+            exit(1);
+        }
+        // a script reads the list, runs its commands and writes the list in one call, the time all goes to the operation
+        phase(STAT_OPERATION);
+        exit(run_script(argv[0], argv[1], argv[3]));
+    }
+
+    // if the last argument (argv[argc-1]) is "/v", set the verbose flag to true
+    int verbose = 0;
+    if (strcmp(argv[argc-1], "/v") == 0 || strcmp(argv[2], "new") == 0) {
+        verbose = 1;
+    }
+
+    // read-only commands are answered from the mapped file without building the list or taking the lock
+    if (mapped_command(argc, argv, verbose, &exitcode) == 0) {
+        exit(exitcode);
+    }
+
+    // the commands below read only what they need of the file as they go
+    phase(STAT_OPERATION);
+
+    // waitpop and waitpopback take the lock each time they look at the list and let go of it while they wait
+    if (wait_command(argc, argv, verbose, &exitcode) == 0) {
+        exit(exitcode);
+    }
+
+    // every other command may change the list, wait for any other writer to finish first
+    // the lock is held until the process exits, so every path below writes its change under it
+    list_lock lock;
+    if (lock_list(argv[1], &lock) != 0) {
+        printf("Error: could not lock list file %s.\n", argv[1]);
+        exit(4);
+    }
+
+    // push and pop on a front-offset list only touch the front of the file
+    if (front_command(argc, argv, verbose, &exitcode) == 0) {
+        exit(exitcode);
+    }
+
+    // reverse streams the file backwards into a new one, so a list bigger than memory can be reversed
+    if (strcmp(argv[2], "reverse") == 0 || strcmp(argv[2], "/rv") == 0) {
+        int result = map_reverse(argv[1]);
+        if (result != 1) {
+            // notify if verbose
+            if (result == 0 && verbose) {
+                printf("Reversed list\n");
+            }
+            exit(result == 0 ? 0 : 4);
+        }
+    }
+
+    // a sort of a list file bigger than the memory budget goes through sorted runs on disk
+    if (mem_limit > 0) {
+        FILE *file = fopen(argv[1], "rb");
+        long size = -1;
+        if (file != NULL) {
+            fseek(file, 0, SEEK_END);
+            size = ftell(file);
+            fclose(file);
+        }
+        if (size > (long) mem_limit && external_command(argc, argv, verbose, mem_limit, &exitcode) == 0) {
+            exit(exitcode);
+        }
+    }
+
+    // create the list
+    phase(STAT_PARSE);
+    list = create_list(argv[1]);
+    // the new command may run before the file exists, any other command found it earlier so it could not be read
+    if (list == NULL && strcmp(argv[2], "new") != 0 && strcmp(argv[2], "/nl") != 0) {
+        printf("Error: file %s could not be read, a binary or block list may be damaged.\n", argv[1]);
+        exit(4);
+    }
+    if (list == NULL) {
+        list = new_list();
+    }
+    phase(STAT_OPERATION);
+    exitcode = run_command(list, argc, argv);
+    runaway:
+    // write the changes back to the file, failed commands leave the file alone
+    phase(STAT_WRITE);
+    if (list != NULL && exitcode == 0) {
+        if (save_list(list, argv[1]) != 0) {
+            exitcode = 4;
+        }
+    }
+    exit(exitcode);
+
 }
\ No newline at end of file